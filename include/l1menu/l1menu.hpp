@@ -1,6 +1,7 @@
 #ifndef l1menu_hpp
 #define l1menu_hpp
 
+#include <memory>
 #include <vector>
 #include <string>
 
@@ -23,6 +24,15 @@ class Menu;
 
 const text_type DEFAULT_UUID {"00000000-0000-0000-0000-000000000000"};
 
+// Returns the instance shared by all default constructed copy-on-write
+// members of type T. It is never modified as it is always shared.
+template<typename T>
+const std::shared_ptr<T>& shared_default()
+{
+    static const std::shared_ptr<T> instance = std::make_shared<T>();
+    return instance;
+}
+
 class Cut
 {
 public:
@@ -128,6 +138,11 @@ private:
     text_type m_comment;
 };
 
+// Algorithms share their data between copies, a copy is made on the first
+// modification only (copy-on-write). This keeps copying menus cheap. Data is
+// only modified through setters, there are no mutable accessors. Sharing is
+// not synchronized: an algorithm must not be modified while copies of it are
+// in use by other threads.
 class Algorithm
 {
 public:
@@ -139,59 +154,84 @@ public:
     using external_requirement_type = l1menu::ExternalRequirement;
     using external_requirements_type = std::vector<external_requirement_type>;
 
-    Algorithm() = default;
+    Algorithm() : m_data(shared_default<Data>()) {}
     Algorithm(const text_type& name, const text_type& expression,
               const size_type index, const size_type module_id,
               const size_type module_index, const text_type& comment,
               const labels_type& labels)
-    : m_name(name), m_expression(expression), m_index(index),
-      m_module_id(module_id), m_module_index(module_index), m_comment(comment),
-      m_labels(labels) {}
+    : m_data(std::make_shared<Data>(name, expression, index, module_id,
+                                    module_index, comment, labels)) {}
     ~Algorithm() = default;
 
-    const text_type& name() const { return m_name; }
-    void set_name(const text_type& name) { m_name = name; }
+    const text_type& name() const { return m_data->name; }
+    void set_name(const text_type& name) { data().name = name; }
 
-    const text_type& expression() const { return m_expression; }
-    void set_expression(const text_type& expression) { m_expression = expression; }
+    const text_type& expression() const { return m_data->expression; }
+    void set_expression(const text_type& expression) { data().expression = expression; }
 
-    size_type index() const { return m_index; }
-    void set_index(const size_type index) { m_index = index; }
+    size_type index() const { return m_data->index; }
+    void set_index(const size_type index) { data().index = index; }
 
-    size_type module_id() const { return m_module_id; }
-    void set_module_id(const size_type module_id) { m_module_id = module_id; }
+    size_type module_id() const { return m_data->module_id; }
+    void set_module_id(const size_type module_id) { data().module_id = module_id; }
 
-    size_type module_index() const { return m_module_index; }
-    void set_module_index(const size_type module_index) { m_module_index = module_index; }
+    size_type module_index() const { return m_data->module_index; }
+    void set_module_index(const size_type module_index) { data().module_index = module_index; }
 
-    const labels_type& labels() const { return m_labels; }
-    labels_type& labels() { return m_labels; }
-    void set_labels(const labels_type& labels) { m_labels = labels; }
-    void add_label(const text_type& label) { m_labels.emplace_back(label); }
+    const labels_type& labels() const { return m_data->labels; }
+    void set_labels(const labels_type& labels) { data().labels = labels; }
+    void add_label(const text_type& label) { data().labels.emplace_back(label); }
 
-    const text_type& comment() const { return m_comment; }
-    void set_comment(const text_type& comment) { m_comment = comment; }
+    const text_type& comment() const { return m_data->comment; }
+    void set_comment(const text_type& comment) { data().comment = comment; }
+
+    const cuts_type& cuts() const { return m_data->cuts; }
+    void set_cuts(const cuts_type& cuts) { data().cuts = cuts; }
 
-    const cuts_type& cuts() const { return m_cuts; }
-    void set_cuts(const cuts_type& cuts) { m_cuts = cuts; }
+    const object_requirements_type& object_requirements() const { return m_data->object_requirements; }
+    void set_object_requirements(const object_requirements_type& object_requirements) { data().object_requirements = object_requirements; }
 
-    const object_requirements_type& object_requirements() const { return m_object_requirements; }
-    void set_object_requirements(const object_requirements_type& object_requirements) { m_object_requirements = object_requirements; }
+    const external_requirements_type& external_requirements() const { return m_data->external_requirements; }
+    void set_external_requirements(const external_requirements_type& external_requirements) { data().external_requirements = external_requirements; }
 
-    const external_requirements_type& external_requirements() const { return m_external_requirements; }
-    void set_external_requirements(const external_requirements_type& external_requirements) { m_external_requirements = external_requirements; }
+    // Returns true if both algorithms refer to the same unmodified data.
+    bool shares_data(const Algorithm& other) const { return m_data == other.m_data; }
 
 private:
-    text_type m_name;
-    text_type m_expression;
-    size_type m_index = 0;
-    size_type m_module_id = 0;
-    size_type m_module_index = 0;
-    text_type m_comment;
-    labels_type m_labels;
-    cuts_type m_cuts;
-    object_requirements_type m_object_requirements;
-    external_requirements_type m_external_requirements;
+    struct Data
+    {
+        Data() = default;
+        Data(const text_type& name, const text_type& expression,
+             const size_type index, const size_type module_id,
+             const size_type module_index, const text_type& comment,
+             const labels_type& labels)
+        : name(name), expression(expression), index(index),
+          module_id(module_id), module_index(module_index), comment(comment),
+          labels(labels) {}
+
+        text_type name;
+        text_type expression;
+        size_type index = 0;
+        size_type module_id = 0;
+        size_type module_index = 0;
+        text_type comment;
+        labels_type labels;
+        cuts_type cuts;
+        object_requirements_type object_requirements;
+        external_requirements_type external_requirements;
+    };
+
+    // Returns data for modification, detaching it from other copies first.
+    // The use_count() check is not synchronized with copies made or released
+    // concurrently by other threads.
+    Data& data()
+    {
+        if (m_data.use_count() != 1)
+            m_data = std::make_shared<Data>(*m_data);
+        return *m_data;
+    }
+
+    std::shared_ptr<Data> m_data;
 };
 
 class Bin
@@ -336,6 +376,8 @@ private:
     ext_signals_type m_ext_signals;
 };
 
+// Menus share algorithm data (see Algorithm), scale set and ext signal set
+// between copies, so menu variants only pay for what they modify.
 class Menu
 {
 public:
@@ -360,8 +402,9 @@ public:
          const ext_signal_set_type& ext_signal_set)
     : m_name(name), m_uuid_menu(uuid_menu), m_uuid_firmware(uuid_firmware),
       m_grammar_version(grammar_version), m_n_modules(n_modules),
-      m_comment(comment), m_algorithms(algorithms), m_scale_set(scale_set),
-      m_ext_signal_set(ext_signal_set) {}
+      m_comment(comment), m_algorithms(algorithms),
+      m_scale_set(std::make_shared<const scale_set_type>(scale_set)),
+      m_ext_signal_set(std::make_shared<const ext_signal_set_type>(ext_signal_set)) {}
     ~Menu() = default;
 
     const text_type& name() const { return m_name; }
@@ -383,13 +426,14 @@ public:
     void set_comment(const text_type& comment) { m_comment = comment; }
 
     const algorithms_type& algorithms() const { return m_algorithms; }
+    algorithms_type& algorithms() { return m_algorithms; }
     void add_algorithm(const algorithm_type& algorithm) { m_algorithms.emplace_back(algorithm); }
 
-    const scale_set_type& scale_set() const { return m_scale_set; }
-    void set_scale_set(const scale_set_type& scale_set) { m_scale_set = scale_set; }
+    const scale_set_type& scale_set() const { return *m_scale_set; }
+    void set_scale_set(const scale_set_type& scale_set) { m_scale_set = std::make_shared<const scale_set_type>(scale_set); }
 
-    const ext_signal_set_type& ext_signal_set() const { return m_ext_signal_set; }
-    void set_ext_signal_set(const ext_signal_set_type& ext_signal_set) { m_ext_signal_set = ext_signal_set; }
+    const ext_signal_set_type& ext_signal_set() const { return *m_ext_signal_set; }
+    void set_ext_signal_set(const ext_signal_set_type& ext_signal_set) { m_ext_signal_set = std::make_shared<const ext_signal_set_type>(ext_signal_set); }
 
 private:
     text_type m_name;
@@ -399,8 +443,8 @@ private:
     size_type m_n_modules = 0;
     text_type m_comment;
     algorithms_type m_algorithms;
-    scale_set_type m_scale_set;
-    ext_signal_set_type m_ext_signal_set;
+    std::shared_ptr<const scale_set_type> m_scale_set = shared_default<scale_set_type>();
+    std::shared_ptr<const ext_signal_set_type> m_ext_signal_set = shared_default<ext_signal_set_type>();
 };
 
 } // l1menu
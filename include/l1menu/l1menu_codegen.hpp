@@ -0,0 +1,316 @@
+#ifndef l1menu_codegen_hpp
+#define l1menu_codegen_hpp
+
+#include <l1menu/l1menu.hpp>
+#include <l1menu/l1menu_static.hpp>
+
+#include <iomanip>
+#include <limits>
+#include <ostream>
+#include <sstream>
+#include <utility>
+#include <vector>
+
+namespace l1menu {
+
+inline std::string
+cpp_string_literal(const std::string& text)
+{
+  std::ostringstream oss;
+  oss << '"';
+  for (const auto c: text)
+  {
+    switch (c)
+    {
+      case '"': oss << "\\\""; break;
+      case '\\': oss << "\\\\"; break;
+      case '\n': oss << "\\n"; break;
+      case '\t': oss << "\\t"; break;
+      case '\r': oss << "\\r"; break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20 or c == 0x7f)
+          oss << '\\' << std::oct << std::setw(3) << std::setfill('0')
+              << static_cast<unsigned>(static_cast<unsigned char>(c))
+              << std::dec << std::setfill(' ');
+        else
+          oss << c;
+    }
+  }
+  oss << '"';
+  return oss.str();
+}
+
+inline std::string
+cpp_decimal_literal(const decimal_type value)
+{
+  std::ostringstream oss;
+  oss << std::scientific << std::setprecision(std::numeric_limits<decimal_type>::max_digits10) << value << 'L';
+  return oss.str();
+}
+
+// Returns a range initializer into a flat table, or an empty range.
+inline std::string
+cpp_range(const std::string& table, const size_type offset, const size_type size)
+{
+  if (not size) return "{}";
+  std::ostringstream oss;
+  oss << "{" << table << " + " << offset << ", " << size << "}";
+  return oss.str();
+}
+
+// Writes a header embedding the menu as constexpr tables in namespace
+// name_space. The header exposes `menu()` (l1menu::StaticMenu), a traits class
+// template `algorithm<Index>` per algorithm index with constexpr accessors
+// for name, module and object requirement thresholds and bx offsets, and
+// `evaluate(index, evaluator)` which dispatches a runtime index to
+// `evaluator.template evaluate<algorithm<Index>>()`.
+inline void
+write_cpp(const l1menu::Menu& menu, std::ostream& os, const std::string& name_space)
+{
+  const auto& algorithms = menu.algorithms();
+  const auto& scales = menu.scale_set().scales();
+  const auto& ext_signals = menu.ext_signal_set().ext_signals();
+
+  size_type n_labels = 0;
+  size_type n_cuts = 0;
+  size_type n_object_requirements = 0;
+  size_type n_external_requirements = 0;
+  size_type n_bins = 0;
+  for (const auto& algorithm: algorithms)
+  {
+    n_labels += algorithm.labels().size();
+    n_cuts += algorithm.cuts().size();
+    n_object_requirements += algorithm.object_requirements().size();
+    n_external_requirements += algorithm.external_requirements().size();
+  }
+  for (const auto& scale: scales)
+    n_bins += scale.bins().size();
+
+  const auto guard = "l1menu_generated_" + name_space + "_hpp";
+
+  os << "// Generated by l1menu::write_cpp from menu " << menu.name() << ", do not edit.\n";
+  os << "#ifndef " << guard << "\n";
+  os << "#define " << guard << "\n\n";
+  os << "#include <l1menu/l1menu_static.hpp>\n\n";
+  os << "namespace " << name_space << " {\n\n";
+  os << "using l1menu::size_type;\n\n";
+
+  // Tables are static members of a class template, so they have a single
+  // definition across translation units like inline variables.
+  os << "template<typename = void>\n"
+     << "struct tables\n"
+     << "{\n";
+
+  if (n_labels)
+  {
+    os << "  static constexpr l1menu::static_text_type labels[] = {\n";
+    for (const auto& algorithm: algorithms)
+      for (const auto& label: algorithm.labels())
+        os << "    " << cpp_string_literal(label) << ",\n";
+    os << "  };\n\n";
+  }
+
+  if (n_cuts)
+  {
+    os << "  static constexpr l1menu::StaticCut cuts[] = {\n";
+    for (const auto& algorithm: algorithms)
+      for (const auto& cut: algorithm.cuts())
+        os << "    {" << cpp_string_literal(cut.name()) << ", "
+           << cpp_string_literal(cut.object()) << ", "
+           << cpp_string_literal(cut.type()) << ", "
+           << cpp_decimal_literal(cut.minimum()) << ", "
+           << cpp_decimal_literal(cut.maximum()) << ", "
+           << cpp_string_literal(cut.data()) << ", "
+           << cpp_string_literal(cut.comment()) << "},\n";
+    os << "  };\n\n";
+  }
+
+  if (n_object_requirements)
+  {
+    os << "  static constexpr l1menu::StaticObjectRequirement object_requirements[] = {\n";
+    for (const auto& algorithm: algorithms)
+      for (const auto& object_requirement: algorithm.object_requirements())
+        os << "    {" << cpp_string_literal(object_requirement.name()) << ", "
+           << cpp_string_literal(object_requirement.type()) << ", "
+           << cpp_string_literal(object_requirement.comparison_operator()) << ", "
+           << cpp_decimal_literal(object_requirement.threshold()) << ", "
+           << object_requirement.bx_offset() << ", "
+           << cpp_string_literal(object_requirement.comment()) << "},\n";
+    os << "  };\n\n";
+  }
+
+  if (n_external_requirements)
+  {
+    os << "  static constexpr l1menu::StaticExternalRequirement external_requirements[] = {\n";
+    for (const auto& algorithm: algorithms)
+      for (const auto& external_requirement: algorithm.external_requirements())
+        os << "    {" << cpp_string_literal(external_requirement.name()) << ", "
+           << external_requirement.bx_offset() << ", "
+           << cpp_string_literal(external_requirement.comment()) << "},\n";
+    os << "  };\n\n";
+  }
+
+  if (algorithms.size())
+  {
+    size_type label_offset = 0;
+    size_type cut_offset = 0;
+    size_type object_requirement_offset = 0;
+    size_type external_requirement_offset = 0;
+    os << "  static constexpr l1menu::StaticAlgorithm algorithms[] = {\n";
+    for (const auto& algorithm: algorithms)
+    {
+      os << "    {" << cpp_string_literal(algorithm.name()) << ",\n"
+         << "     " << cpp_string_literal(algorithm.expression()) << ",\n"
+         << "     " << algorithm.index() << ", " << algorithm.module_id() << ", "
+         << algorithm.module_index() << ", "
+         << cpp_string_literal(algorithm.comment()) << ",\n"
+         << "     " << cpp_range("labels", label_offset, algorithm.labels().size()) << ", "
+         << cpp_range("cuts", cut_offset, algorithm.cuts().size()) << ", "
+         << cpp_range("object_requirements", object_requirement_offset, algorithm.object_requirements().size()) << ", "
+         << cpp_range("external_requirements", external_requirement_offset, algorithm.external_requirements().size()) << "},\n";
+      label_offset += algorithm.labels().size();
+      cut_offset += algorithm.cuts().size();
+      object_requirement_offset += algorithm.object_requirements().size();
+      external_requirement_offset += algorithm.external_requirements().size();
+    }
+    os << "  };\n\n";
+  }
+
+  if (n_bins)
+  {
+    os << "  static constexpr l1menu::StaticBin bins[] = {\n";
+    for (const auto& scale: scales)
+      for (const auto& bin: scale.bins())
+        os << "    {" << bin.number() << ", " << cpp_decimal_literal(bin.minimum())
+           << ", " << cpp_decimal_literal(bin.maximum()) << "},\n";
+    os << "  };\n\n";
+  }
+
+  if (scales.size())
+  {
+    size_type bin_offset = 0;
+    os << "  static constexpr l1menu::StaticScale scales[] = {\n";
+    for (const auto& scale: scales)
+    {
+      os << "    {" << cpp_string_literal(scale.object()) << ", "
+         << cpp_string_literal(scale.type()) << ", "
+         << cpp_decimal_literal(scale.minimum()) << ", "
+         << cpp_decimal_literal(scale.maximum()) << ", "
+         << cpp_decimal_literal(scale.step()) << ", "
+         << scale.nbits() << ", "
+         << cpp_string_literal(scale.comment()) << ", "
+         << cpp_range("bins", bin_offset, scale.bins().size()) << "},\n";
+      bin_offset += scale.bins().size();
+    }
+    os << "  };\n\n";
+  }
+
+  if (ext_signals.size())
+  {
+    os << "  static constexpr l1menu::StaticExtSignal ext_signals[] = {\n";
+    for (const auto& ext_signal: ext_signals)
+      os << "    {" << cpp_string_literal(ext_signal.name()) << ", "
+         << cpp_string_literal(ext_signal.system()) << ", "
+         << ext_signal.cable() << ", " << ext_signal.channel() << ", "
+         << cpp_string_literal(ext_signal.description()) << ", "
+         << cpp_string_literal(ext_signal.label()) << "},\n";
+    os << "  };\n\n";
+  }
+
+  os << "  static constexpr l1menu::StaticMenu menu {\n"
+     << "    " << cpp_string_literal(menu.name()) << ",\n"
+     << "    " << cpp_string_literal(menu.uuid_menu()) << ",\n"
+     << "    " << cpp_string_literal(menu.uuid_firmware()) << ",\n"
+     << "    " << cpp_string_literal(menu.grammar_version()) << ",\n"
+     << "    " << menu.n_modules() << ",\n"
+     << "    " << cpp_string_literal(menu.comment()) << ",\n"
+     << "    " << cpp_range("algorithms", 0, algorithms.size()) << ",\n"
+     << "    {" << cpp_string_literal(menu.scale_set().name()) << ", "
+     << cpp_string_literal(menu.scale_set().comment()) << ", "
+     << cpp_range("scales", 0, scales.size()) << "},\n"
+     << "    {" << cpp_string_literal(menu.ext_signal_set().name()) << ", "
+     << cpp_string_literal(menu.ext_signal_set().comment()) << ", "
+     << cpp_range("ext_signals", 0, ext_signals.size()) << "}\n"
+     << "  };\n"
+     << "};\n\n";
+
+  // Out of class definitions give the tables a single address in all
+  // translation units.
+  const std::vector<std::pair<const char*, const char*>> tables {
+    {"l1menu::static_text_type", n_labels ? "labels" : nullptr},
+    {"l1menu::StaticCut", n_cuts ? "cuts" : nullptr},
+    {"l1menu::StaticObjectRequirement", n_object_requirements ? "object_requirements" : nullptr},
+    {"l1menu::StaticExternalRequirement", n_external_requirements ? "external_requirements" : nullptr},
+    {"l1menu::StaticAlgorithm", algorithms.size() ? "algorithms" : nullptr},
+    {"l1menu::StaticBin", n_bins ? "bins" : nullptr},
+    {"l1menu::StaticScale", scales.size() ? "scales" : nullptr},
+    {"l1menu::StaticExtSignal", ext_signals.size() ? "ext_signals" : nullptr},
+  };
+  for (const auto& table: tables)
+    if (table.second)
+      os << "template<typename T>\n"
+         << "constexpr " << table.first << " tables<T>::" << table.second << "[];\n\n";
+  os << "template<typename T>\n"
+     << "constexpr l1menu::StaticMenu tables<T>::menu;\n\n";
+
+  os << "constexpr const l1menu::StaticMenu& menu() { return tables<>::menu; }\n\n";
+
+  // Traits and dispatch are keyed by Algorithm::index(), which may be sparse.
+  os << "template<size_type Index>\n"
+     << "struct algorithm;\n\n";
+
+  size_type position = 0;
+  for (const auto& algorithm: algorithms)
+  {
+    os << "template<>\n"
+       << "struct algorithm<" << algorithm.index() << ">\n"
+       << "{\n"
+       << "  static constexpr size_type index() { return " << algorithm.index() << "; }\n"
+       << "  static constexpr size_type module_id() { return " << algorithm.module_id() << "; }\n"
+       << "  static constexpr size_type module_index() { return " << algorithm.module_index() << "; }\n"
+       << "  static constexpr l1menu::static_text_type name() { return " << cpp_string_literal(algorithm.name()) << "; }\n"
+       << "  static constexpr const l1menu::StaticAlgorithm& data() { return tables<>::algorithms[" << position << "]; }\n"
+       << "  static constexpr size_type n_object_requirements() { return " << algorithm.object_requirements().size() << "; }\n"
+       << "  static constexpr size_type n_external_requirements() { return " << algorithm.external_requirements().size() << "; }\n";
+    const auto& object_requirements = algorithm.object_requirements();
+    os << "  static constexpr l1menu::decimal_type threshold(const size_type"
+       << (object_requirements.size() > 1 ? " i" : "") << ") { return ";
+    for (size_type i = 0; i + 1 < object_requirements.size(); ++i)
+      os << "i == " << i << " ? " << cpp_decimal_literal(object_requirements[i].threshold()) << " : ";
+    os << (object_requirements.empty() ? "0" : cpp_decimal_literal(object_requirements.back().threshold())) << "; }\n";
+    os << "  static constexpr l1menu::offset_type bx_offset(const size_type"
+       << (object_requirements.size() > 1 ? " i" : "") << ") { return ";
+    for (size_type i = 0; i + 1 < object_requirements.size(); ++i)
+      os << "i == " << i << " ? " << object_requirements[i].bx_offset() << " : ";
+    os << (object_requirements.empty() ? 0 : object_requirements.back().bx_offset()) << "; }\n";
+    os << "};\n\n";
+    ++position;
+  }
+
+  os << "template<typename Evaluator>\n"
+     << "bool evaluate(const size_type index, Evaluator& evaluator)\n"
+     << "{\n"
+     << "  switch (index)\n"
+     << "  {\n";
+  for (const auto& algorithm: algorithms)
+    os << "    case " << algorithm.index() << ": return evaluator.template evaluate<algorithm<"
+       << algorithm.index() << ">>();\n";
+  os << "    default: return false;\n"
+     << "  }\n"
+     << "}\n\n";
+
+  os << "} // " << name_space << "\n\n";
+  os << "#endif // " << guard << "\n";
+}
+
+inline std::string
+write_cpp(const l1menu::Menu& menu, const std::string& name_space)
+{
+  std::ostringstream oss;
+  write_cpp(menu, oss, name_space);
+  return oss.str();
+}
+
+} // l1menu
+
+#endif // l1menu_codegen_hpp
@@ -0,0 +1,185 @@
+#ifndef l1menu_external_hpp
+#define l1menu_external_hpp
+
+#include <l1menu/l1menu.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace l1menu {
+
+// External requirement resolved to a signal bit of decoded words.
+class ExternalCondition
+{
+public:
+    ExternalCondition() = default;
+    ExternalCondition(const size_type signal, const offset_type bx_offset,
+                      const size_type word, const std::uint64_t mask)
+    : m_signal(signal), m_bx_offset(bx_offset), m_word(word), m_mask(mask) {}
+    ~ExternalCondition() = default;
+
+    // Position of the signal in the ExtSignalSet.
+    size_type signal() const { return m_signal; }
+    offset_type bx_offset() const { return m_bx_offset; }
+    // Word within a decoded bunch crossing and bit mask of the signal.
+    size_type word() const { return m_word; }
+    std::uint64_t mask() const { return m_mask; }
+
+private:
+    size_type m_signal = 0;
+    offset_type m_bx_offset = 0;
+    size_type m_word = 0;
+    std::uint64_t m_mask = 0;
+};
+
+// Decodes raw external condition words into per-signal bits.
+//
+// Raw input holds raw_words_per_bx() 32 bit words per bunch crossing, one
+// per cable indexed by ExtSignal::cable(), with ExtSignal::channel() as bit
+// position. The number of cables is fixed by the input format, not by the
+// cables a menu happens to use. Decoded output holds words_per_bx() 64 bit words per bunch
+// crossing with one bit per signal in ExtSignalSet order. Bunch crossings
+// are contiguous in both, so BX windows are plain word offsets.
+class ExtSignalDecoder
+{
+public:
+    using raw_word_type = std::uint32_t;
+    using word_type = std::uint64_t;
+    using conditions_type = std::vector<ExternalCondition>;
+
+    static constexpr size_type channels_per_cable = 32;
+    static constexpr size_type word_bits = 64;
+
+    ExtSignalDecoder(const ExtSignalSet& ext_signal_set, const size_type n_cables)
+    : m_raw_words_per_bx(n_cables)
+    {
+        if (not n_cables)
+            throw std::runtime_error("number of external condition cables must be positive");
+        const auto& ext_signals = ext_signal_set.ext_signals();
+        for (size_type signal = 0; signal < ext_signals.size(); ++signal)
+        {
+            const auto& ext_signal = ext_signals[signal];
+            if (ext_signal.cable() >= n_cables)
+                throw std::runtime_error("invalid cable for external signal '" + ext_signal.name() + "'");
+            if (ext_signal.channel() >= channels_per_cable)
+                throw std::runtime_error("invalid channel for external signal '" + ext_signal.name() + "'");
+            m_names.emplace_back(ext_signal.name());
+        }
+        m_words_per_bx = std::max<size_type>(1, (ext_signals.size() + word_bits - 1) / word_bits);
+
+        // Precompute decoded bits set by each cable channel, several signals
+        // may share a channel.
+        m_cable_masks.assign(m_raw_words_per_bx, 0);
+        m_channel_bits.assign(std::size_t(m_raw_words_per_bx) * channels_per_cable * m_words_per_bx, 0);
+        for (size_type signal = 0; signal < ext_signals.size(); ++signal)
+        {
+            const auto& ext_signal = ext_signals[signal];
+            m_cable_masks[ext_signal.cable()] |= raw_word_type(1) << ext_signal.channel();
+            const auto row = (std::size_t(ext_signal.cable()) * channels_per_cable + ext_signal.channel()) * m_words_per_bx;
+            m_channel_bits[row + signal / word_bits] |= word_type(1) << (signal % word_bits);
+        }
+    }
+    ~ExtSignalDecoder() = default;
+
+    size_type n_signals() const { return m_names.size(); }
+    size_type raw_words_per_bx() const { return m_raw_words_per_bx; }
+    size_type words_per_bx() const { return m_words_per_bx; }
+
+    // Returns position of signal name in the ExtSignalSet. Names are matched
+    // with and without the "EXT_" prefix used in algorithm expressions.
+    size_type signal(const text_type& name) const
+    {
+        const text_type prefix = "EXT_";
+        for (size_type signal = 0; signal < m_names.size(); ++signal)
+        {
+            const auto& candidate = m_names[signal];
+            if (candidate == name or prefix + candidate == name or candidate == prefix + name)
+                return signal;
+        }
+        throw std::runtime_error("no external signal '" + name + "'");
+    }
+
+    ExternalCondition resolve(const ExternalRequirement& external_requirement) const
+    {
+        const auto index = signal(external_requirement.name());
+        return ExternalCondition(
+            index, external_requirement.bx_offset(), index / word_bits,
+            word_type(1) << (index % word_bits)
+        );
+    }
+
+    conditions_type resolve(const Algorithm& algorithm) const
+    {
+        conditions_type conditions;
+        for (const auto& external_requirement: algorithm.external_requirements())
+            conditions.emplace_back(resolve(external_requirement));
+        return conditions;
+    }
+
+    // Decodes n_bx bunch crossings from raw into decoded, which must hold
+    // n_bx * words_per_bx() words. Cost scales with the number of set
+    // channels assigned to signals, empty cables are skipped.
+    void decode(const raw_word_type* raw, const std::size_t n_bx, word_type* decoded) const
+    {
+        for (std::size_t bx = 0; bx < n_bx; ++bx)
+        {
+            const auto* raw_bx = raw + bx * m_raw_words_per_bx;
+            auto* decoded_bx = decoded + bx * m_words_per_bx;
+            std::fill_n(decoded_bx, m_words_per_bx, 0);
+            for (size_type cable = 0; cable < m_raw_words_per_bx; ++cable)
+            {
+                auto word = raw_bx[cable] & m_cable_masks[cable];
+                while (word)
+                {
+                    const auto channel = __builtin_ctz(word);
+                    word &= word - 1;
+                    const auto* bits = &m_channel_bits[(std::size_t(cable) * channels_per_cable + channel) * m_words_per_bx];
+                    for (size_type w = 0; w < m_words_per_bx; ++w)
+                        decoded_bx[w] |= bits[w];
+                }
+            }
+        }
+    }
+
+    std::vector<word_type> decode(const std::vector<raw_word_type>& raw) const
+    {
+        if (raw.size() % m_raw_words_per_bx)
+            throw std::runtime_error("raw external condition words do not fill whole bunch crossings");
+        const auto n_bx = raw.size() / m_raw_words_per_bx;
+        std::vector<word_type> decoded(n_bx * m_words_per_bx);
+        decode(raw.data(), n_bx, decoded.data());
+        return decoded;
+    }
+
+    // Tests condition for bunch crossing bx of n_bx decoded bunch crossings,
+    // offsets pointing outside the window fail.
+    bool test(const word_type* decoded, const std::size_t n_bx, const std::size_t bx,
+              const ExternalCondition& condition) const
+    {
+        const auto target = static_cast<long long>(bx) + condition.bx_offset();
+        if (target < 0 or target >= static_cast<long long>(n_bx)) return false;
+        return decoded[target * m_words_per_bx + condition.word()] & condition.mask();
+    }
+
+    // Tests all conditions (logical AND), as required by an algorithm.
+    bool test(const word_type* decoded, const std::size_t n_bx, const std::size_t bx,
+              const conditions_type& conditions) const
+    {
+        for (const auto& condition: conditions)
+            if (not test(decoded, n_bx, bx, condition)) return false;
+        return true;
+    }
+
+private:
+    std::vector<text_type> m_names;
+    std::vector<raw_word_type> m_cable_masks;
+    std::vector<word_type> m_channel_bits;
+    size_type m_raw_words_per_bx;
+    size_type m_words_per_bx = 1;
+};
+
+} // l1menu
+
+#endif // l1menu_external_hpp
@@ -0,0 +1,375 @@
+#ifndef l1menu_json_hpp
+#define l1menu_json_hpp
+
+#include <l1menu/l1menu.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+namespace l1menu {
+
+// Selects sections written by write_json(), skipping heavy sections like
+// scale bins keeps dashboard payloads small.
+struct JsonOptions
+{
+  bool algorithms = true;
+  bool cuts = true;
+  bool requirements = true;
+  bool scales = true;
+  bool bins = true;
+  bool ext_signals = true;
+};
+
+// Sink writing to an std::ostream through a small local buffer.
+class JsonStreamSink
+{
+public:
+  explicit JsonStreamSink(std::ostream& os) : m_os(os) {}
+  ~JsonStreamSink() { flush(); }
+
+  void write(const char* data, const std::size_t size)
+  {
+    if (m_size + size > sizeof(m_buffer))
+    {
+      flush();
+      if (size > sizeof(m_buffer))
+      {
+        m_os.write(data, size);
+        return;
+      }
+    }
+    std::memcpy(m_buffer + m_size, data, size);
+    m_size += size;
+  }
+
+  void flush()
+  {
+    if (m_size) m_os.write(m_buffer, m_size);
+    m_size = 0;
+  }
+
+private:
+  std::ostream& m_os;
+  char m_buffer[4096];
+  std::size_t m_size = 0;
+};
+
+// Sink writing to a caller provided buffer. Output exceeding the buffer is
+// dropped but still counted, so length() reports the size required.
+class JsonBufferSink
+{
+public:
+  JsonBufferSink(char* buffer, const std::size_t size)
+  : m_buffer(buffer), m_capacity(size) {}
+
+  void write(const char* data, const std::size_t size)
+  {
+    if (m_length < m_capacity)
+      std::memcpy(m_buffer + m_length, data, std::min(size, m_capacity - m_length));
+    m_length += size;
+  }
+
+  void flush() {}
+
+  std::size_t length() const { return m_length; }
+
+private:
+  char* m_buffer;
+  std::size_t m_capacity;
+  std::size_t m_length = 0;
+};
+
+template<typename Sink>
+class JsonWriter
+{
+public:
+  JsonWriter(Sink& sink, const JsonOptions& options)
+  : m_sink(sink), m_options(options) {}
+
+  void write(const l1menu::Menu& menu)
+  {
+    put('{');
+    key("name"); string(menu.name());
+    key("uuid_menu"); string(menu.uuid_menu());
+    key("uuid_firmware"); string(menu.uuid_firmware());
+    key("grammar_version"); string(menu.grammar_version());
+    key("n_modules"); number(menu.n_modules());
+    key("comment"); string(menu.comment());
+    if (m_options.algorithms)
+    {
+      key("algorithms"); put('[');
+      for (const auto& algorithm: menu.algorithms())
+      {
+        separator();
+        write(algorithm);
+      }
+      put(']');
+    }
+    if (m_options.scales)
+    {
+      key("scale_set"); write(menu.scale_set());
+    }
+    if (m_options.ext_signals)
+    {
+      key("ext_signal_set"); write(menu.ext_signal_set());
+    }
+    put('}');
+    m_sink.flush();
+  }
+
+private:
+  void write(const l1menu::Algorithm& algorithm)
+  {
+    put('{');
+    key("name"); string(algorithm.name());
+    key("expression"); string(algorithm.expression());
+    key("index"); number(algorithm.index());
+    key("module_id"); number(algorithm.module_id());
+    key("module_index"); number(algorithm.module_index());
+    key("comment"); string(algorithm.comment());
+    key("labels"); put('[');
+    for (const auto& label: algorithm.labels())
+      string(label);
+    put(']');
+    if (m_options.cuts)
+    {
+      key("cuts"); put('[');
+      for (const auto& cut: algorithm.cuts())
+      {
+        separator();
+        put('{');
+        key("name"); string(cut.name());
+        key("object"); string(cut.object());
+        key("type"); string(cut.type());
+        key("minimum"); decimal(cut.minimum());
+        key("maximum"); decimal(cut.maximum());
+        key("data"); string(cut.data());
+        key("comment"); string(cut.comment());
+        put('}');
+      }
+      put(']');
+    }
+    if (m_options.requirements)
+    {
+      key("object_requirements"); put('[');
+      for (const auto& object_requirement: algorithm.object_requirements())
+      {
+        separator();
+        put('{');
+        key("name"); string(object_requirement.name());
+        key("type"); string(object_requirement.type());
+        key("comparison_operator"); string(object_requirement.comparison_operator());
+        key("threshold"); decimal(object_requirement.threshold());
+        key("bx_offset"); number(object_requirement.bx_offset());
+        key("comment"); string(object_requirement.comment());
+        put('}');
+      }
+      put(']');
+      key("external_requirements"); put('[');
+      for (const auto& external_requirement: algorithm.external_requirements())
+      {
+        separator();
+        put('{');
+        key("name"); string(external_requirement.name());
+        key("bx_offset"); number(external_requirement.bx_offset());
+        key("comment"); string(external_requirement.comment());
+        put('}');
+      }
+      put(']');
+    }
+    put('}');
+  }
+
+  void write(const l1menu::ScaleSet& scale_set)
+  {
+    put('{');
+    key("name"); string(scale_set.name());
+    key("comment"); string(scale_set.comment());
+    key("scales"); put('[');
+    for (const auto& scale: scale_set.scales())
+    {
+      separator();
+      put('{');
+      key("object"); string(scale.object());
+      key("type"); string(scale.type());
+      key("minimum"); decimal(scale.minimum());
+      key("maximum"); decimal(scale.maximum());
+      key("step"); decimal(scale.step());
+      key("n_bits"); number(scale.nbits());
+      key("comment"); string(scale.comment());
+      if (m_options.bins)
+      {
+        key("bins"); put('[');
+        for (const auto& bin: scale.bins())
+        {
+          separator();
+          put('{');
+          key("number"); number(bin.number());
+          key("minimum"); decimal(bin.minimum());
+          key("maximum"); decimal(bin.maximum());
+          put('}');
+        }
+        put(']');
+      }
+      put('}');
+    }
+    put(']');
+    put('}');
+  }
+
+  void write(const l1menu::ExtSignalSet& ext_signal_set)
+  {
+    put('{');
+    key("name"); string(ext_signal_set.name());
+    key("comment"); string(ext_signal_set.comment());
+    key("ext_signals"); put('[');
+    for (const auto& ext_signal: ext_signal_set.ext_signals())
+    {
+      separator();
+      put('{');
+      key("name"); string(ext_signal.name());
+      key("system"); string(ext_signal.system());
+      key("cable"); number(ext_signal.cable());
+      key("channel"); number(ext_signal.channel());
+      key("description"); string(ext_signal.description());
+      key("label"); string(ext_signal.label());
+      put('}');
+    }
+    put(']');
+    put('}');
+  }
+
+  // Opening brackets suppress the separator of the first following element,
+  // scalar values write their own separator.
+  void put(const char c)
+  {
+    m_sink.write(&c, 1);
+    m_first = (c == '{' or c == '[');
+  }
+
+  void raw(const char* data, const std::size_t size)
+  {
+    m_sink.write(data, size);
+    m_first = false;
+  }
+
+  void separator()
+  {
+    if (not m_first) m_sink.write(",", 1);
+    m_first = false;
+  }
+
+  template<std::size_t N>
+  void key(const char (&name)[N])
+  {
+    separator();
+    m_sink.write("\"", 1);
+    m_sink.write(name, N - 1);
+    m_sink.write("\":", 2);
+    m_first = true;
+  }
+
+  void string(const text_type& text)
+  {
+    static const char hex[] = "0123456789abcdef";
+    separator();
+    m_sink.write("\"", 1);
+    std::size_t begin = 0;
+    for (std::size_t i = 0; i < text.size(); ++i)
+    {
+      const auto c = static_cast<unsigned char>(text[i]);
+      if (c >= 0x20 and c != '"' and c != '\\') continue;
+      m_sink.write(text.data() + begin, i - begin);
+      begin = i + 1;
+      switch (c)
+      {
+        case '"': m_sink.write("\\\"", 2); break;
+        case '\\': m_sink.write("\\\\", 2); break;
+        case '\n': m_sink.write("\\n", 2); break;
+        case '\t': m_sink.write("\\t", 2); break;
+        case '\r': m_sink.write("\\r", 2); break;
+        default:
+        {
+          const char escaped[] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xf]};
+          m_sink.write(escaped, sizeof(escaped));
+        }
+      }
+    }
+    m_sink.write(text.data() + begin, text.size() - begin);
+    m_sink.write("\"", 1);
+    m_first = false;
+  }
+
+  template<typename T>
+  void number(const T value)
+  {
+    char buffer[24];
+    char* end = buffer + sizeof(buffer);
+    char* p = end;
+    const bool negative = value < 0;
+    unsigned long long n = negative ? -static_cast<long long>(value) : value;
+    do { *--p = '0' + n % 10; n /= 10; } while (n);
+    if (negative) *--p = '-';
+    separator();
+    raw(p, end - p);
+  }
+
+  // Writes 17 significant digits (as written by write_xml), JSON has no
+  // representation for non finite values.
+  void decimal(const decimal_type value)
+  {
+    separator();
+    if (not std::isfinite(value))
+    {
+      raw("null", 4);
+      return;
+    }
+    char buffer[48];
+    const auto size = std::snprintf(buffer, sizeof(buffer), "%.17Lg", value);
+    raw(buffer, size);
+  }
+
+  Sink& m_sink;
+  JsonOptions m_options;
+  bool m_first = true;
+};
+
+// Streams a menu as compact JSON to os.
+inline void
+write_json(const l1menu::Menu& menu, std::ostream& os,
+           const JsonOptions& options = JsonOptions())
+{
+  JsonStreamSink sink(os);
+  JsonWriter<JsonStreamSink> writer(sink, options);
+  writer.write(menu);
+}
+
+// Writes a menu as compact JSON into buffer, truncating at size. Returns the
+// length of the complete document; if it is not less than size the output was
+// truncated. The output is not null terminated.
+inline std::size_t
+write_json(const l1menu::Menu& menu, char* buffer, const std::size_t size,
+           const JsonOptions& options = JsonOptions())
+{
+  JsonBufferSink sink(buffer, size);
+  JsonWriter<JsonBufferSink> writer(sink, options);
+  writer.write(menu);
+  return sink.length();
+}
+
+inline std::string
+write_json(const l1menu::Menu& menu)
+{
+  std::ostringstream oss;
+  write_json(menu, oss);
+  return oss.str();
+}
+
+} // l1menu
+
+#endif // l1menu_json_hpp
@@ -0,0 +1,213 @@
+#ifndef l1menu_overlap_hpp
+#define l1menu_overlap_hpp
+
+#include <l1menu/l1menu.hpp>
+#include <l1menu/l1menu_popcount.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace l1menu {
+
+// Accumulates pairwise overlap counts, unique (pure) counts and the total
+// count of events from per-event trigger decisions.
+//
+// Decisions of an event are packed as bits in Algorithm::index() order into
+// words_per_event() 64 bit words, events are contiguous. Events are processed
+// in blocks which are transposed into one bit column per algorithm, overlaps
+// are then popcounts of ANDed columns computed in cache sized tiles for the
+// algorithms active in the block, using the popcount kernel selected for the
+// running CPU. Only the upper triangle is stored. The first thread fills the
+// result directly, further threads fill partial matrices kept across calls
+// which are reduced and cleared at the end of fill(). This costs
+// O(threads * size()^2) per call, so pass events in large batches when using
+// several threads.
+class OverlapMatrix
+{
+public:
+    using word_type = std::uint64_t;
+    using count_type = std::uint64_t;
+    using counts_type = std::vector<count_type>;
+    using names_type = std::vector<text_type>;
+
+    static constexpr size_type word_bits = 64;
+    static constexpr size_type block_words = 64;
+    static constexpr size_type block_events = block_words * word_bits;
+    static constexpr size_type tile_size = 32;
+
+    explicit OverlapMatrix(const Menu& menu)
+    {
+        size_type size = 0;
+        for (const auto& algorithm: menu.algorithms())
+            size = std::max(size, algorithm.index() + 1);
+        m_size = size;
+        m_names.resize(size);
+        for (const auto& algorithm: menu.algorithms())
+            m_names[algorithm.index()] = algorithm.name();
+        m_counts = Partial(size);
+    }
+    ~OverlapMatrix() = default;
+
+    // Number of rows and columns, highest algorithm index + 1.
+    size_type size() const { return m_size; }
+    size_type words_per_event() const { return (m_size + word_bits - 1) / word_bits; }
+
+    // Returns algorithm name for index, empty for unassigned indices.
+    const text_type& name(const size_type index) const { return m_names[index]; }
+    const names_type& names() const { return m_names; }
+
+    count_type events() const { return m_events; }
+    count_type total() const { return m_counts.total; }
+    count_type rate(const size_type index) const { return overlap(index, index); }
+    count_type unique(const size_type index) const { return m_counts.unique[index]; }
+    count_type overlap(const size_type i, const size_type j) const
+    {
+        return m_counts.overlaps[std::size_t(std::min(i, j)) * m_size + std::max(i, j)];
+    }
+
+    // Adds n_events events, may be called repeatedly to stream samples.
+    void fill(const word_type* words, const std::size_t n_events,
+              size_type n_threads = std::thread::hardware_concurrency())
+    {
+        const std::size_t n_blocks = (n_events + block_events - 1) / block_events;
+        n_threads = std::max<size_type>(1, std::min<std::size_t>(n_threads, n_blocks));
+
+        if (m_partials.size() < n_threads - 1)
+            m_partials.resize(n_threads - 1, Partial(m_size));
+        const auto work = [&](const size_type thread) {
+            const auto first = n_blocks * thread / n_threads * block_events;
+            const auto last = std::min<std::size_t>(n_blocks * (thread + 1) / n_threads * block_events, n_events);
+            process(thread ? m_partials[thread - 1] : m_counts, words, first, last);
+        };
+
+        std::vector<std::thread> threads;
+        for (size_type thread = 1; thread < n_threads; ++thread)
+            threads.emplace_back(work, thread);
+        work(0);
+        for (auto& thread: threads)
+            thread.join();
+
+        // Reduce partial upper triangles into the result and clear them.
+        for (size_type thread = 0; thread + 1 < n_threads; ++thread)
+        {
+            auto& partial = m_partials[thread];
+            m_counts.total += partial.total;
+            partial.total = 0;
+            for (size_type i = 0; i < m_size; ++i)
+            {
+                m_counts.unique[i] += partial.unique[i];
+                partial.unique[i] = 0;
+                for (size_type j = i; j < m_size; ++j)
+                {
+                    auto& count = partial.overlaps[std::size_t(i) * m_size + j];
+                    m_counts.overlaps[std::size_t(i) * m_size + j] += count;
+                    count = 0;
+                }
+            }
+        }
+        m_events += n_events;
+    }
+
+private:
+    struct Partial
+    {
+        Partial() = default;
+        explicit Partial(const size_type size)
+        : overlaps(std::size_t(size) * size, 0), unique(size, 0) {}
+
+        counts_type overlaps;
+        counts_type unique;
+        count_type total = 0;
+    };
+
+    void process(Partial& partial, const word_type* words, std::size_t first, const std::size_t last) const
+    {
+        const auto n_words = words_per_event();
+        std::vector<word_type> columns(std::size_t(m_size) * block_words, 0);
+        std::vector<size_type> active;
+        std::vector<bool> is_active(m_size, false);
+
+        for (; first < last; first += block_events)
+        {
+            const auto n = std::min<std::size_t>(block_events, last - first);
+
+            // Transpose event rows into algorithm columns, count unique and total.
+            for (std::size_t event = 0; event < n; ++event)
+            {
+                const auto* row = words + (first + event) * n_words;
+                size_type fired = 0;
+                size_type last_fired = 0;
+                for (size_type w = 0; w < n_words; ++w)
+                {
+                    auto word = row[w];
+                    while (word)
+                    {
+                        const auto index = w * word_bits + __builtin_ctzll(word);
+                        word &= word - 1;
+                        if (index >= m_size) continue;
+                        if (not is_active[index])
+                        {
+                            is_active[index] = true;
+                            active.emplace_back(index);
+                        }
+                        columns[std::size_t(index) * block_words + event / word_bits] |= word_type(1) << (event % word_bits);
+                        last_fired = index;
+                        ++fired;
+                    }
+                }
+                if (fired) ++partial.total;
+                if (fired == 1) ++partial.unique[last_fired];
+            }
+
+            std::sort(active.begin(), active.end());
+            overlaps(partial, columns, active);
+
+            for (const auto index: active)
+            {
+                std::fill_n(columns.begin() + std::size_t(index) * block_words, block_words, 0);
+                is_active[index] = false;
+            }
+            active.clear();
+        }
+    }
+
+    // Adds popcounts of ANDed columns for all pairs of active algorithms,
+    // iterating tiles of tile_size x tile_size columns to stay in cache.
+    void overlaps(Partial& partial, const std::vector<word_type>& columns,
+                  const std::vector<size_type>& active) const
+    {
+        const auto popcount_and = popcount_and_kernel();
+        const auto n_active = active.size();
+        for (std::size_t ti = 0; ti < n_active; ti += tile_size)
+        {
+            const auto ti_end = std::min<std::size_t>(ti + tile_size, n_active);
+            for (std::size_t tj = ti; tj < n_active; tj += tile_size)
+            {
+                const auto tj_end = std::min<std::size_t>(tj + tile_size, n_active);
+                for (auto i = ti; i < ti_end; ++i)
+                {
+                    const auto a = active[i];
+                    const auto* column_a = &columns[std::size_t(a) * block_words];
+                    auto* row = &partial.overlaps[std::size_t(a) * m_size];
+                    for (auto j = std::max(tj, i); j < tj_end; ++j)
+                    {
+                        const auto b = active[j];
+                        row[b] += popcount_and(column_a, &columns[std::size_t(b) * block_words], block_words);
+                    }
+                }
+            }
+        }
+    }
+
+    size_type m_size = 0;
+    names_type m_names;
+    Partial m_counts;
+    std::vector<Partial> m_partials;
+    count_type m_events = 0;
+};
+
+} // l1menu
+
+#endif // l1menu_overlap_hpp
@@ -0,0 +1,124 @@
+#ifndef l1menu_popcount_hpp
+#define l1menu_popcount_hpp
+
+#include <l1menu/l1menu.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define l1menu_popcount_dispatch
+#include <immintrin.h>
+#endif
+
+namespace l1menu {
+
+// Returns number of set bits. Uses the popcnt instruction if enabled at
+// compile time, otherwise a branch free bit count instead of the library
+// call __builtin_popcountll falls back to.
+inline size_type
+popcount64(std::uint64_t x)
+{
+#if defined(__POPCNT__)
+  return __builtin_popcountll(x);
+#else
+  x = x - ((x >> 1) & 0x5555555555555555ULL);
+  x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+  x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+  return static_cast<size_type>((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+using popcount_and_type = std::uint64_t (*)(const std::uint64_t*, const std::uint64_t*, std::size_t);
+
+// Returns number of bits set in both a and b over n words.
+inline std::uint64_t
+popcount_and_generic(const std::uint64_t* a, const std::uint64_t* b, const std::size_t n)
+{
+  std::uint64_t count = 0;
+  for (std::size_t i = 0; i < n; ++i)
+    count += popcount64(a[i] & b[i]);
+  return count;
+}
+
+#ifdef l1menu_popcount_dispatch
+
+__attribute__((target("popcnt"))) inline std::uint64_t
+popcount_and_popcnt(const std::uint64_t* a, const std::uint64_t* b, const std::size_t n)
+{
+  std::uint64_t count = 0;
+  for (std::size_t i = 0; i < n; ++i)
+    count += __builtin_popcountll(a[i] & b[i]);
+  return count;
+}
+
+// Counts nibbles of four words at once through a 16 entry lookup table
+// (vpshufb), byte counts are summed into 64 bit lanes by vpsadbw.
+__attribute__((target("avx2,popcnt"))) inline std::uint64_t
+popcount_and_avx2(const std::uint64_t* a, const std::uint64_t* b, const std::size_t n)
+{
+  const __m256i lookup = _mm256_setr_epi8(
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4
+  );
+  const __m256i low_mask = _mm256_set1_epi8(0x0f);
+  __m256i total = _mm256_setzero_si256();
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4)
+  {
+    const __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    const __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    const __m256i v = _mm256_and_si256(va, vb);
+    const __m256i low = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low_mask));
+    const __m256i high = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low_mask));
+    total = _mm256_add_epi64(total, _mm256_sad_epu8(_mm256_add_epi8(low, high), _mm256_setzero_si256()));
+  }
+  std::uint64_t count =
+    static_cast<std::uint64_t>(_mm256_extract_epi64(total, 0)) +
+    static_cast<std::uint64_t>(_mm256_extract_epi64(total, 1)) +
+    static_cast<std::uint64_t>(_mm256_extract_epi64(total, 2)) +
+    static_cast<std::uint64_t>(_mm256_extract_epi64(total, 3));
+  for (; i < n; ++i)
+    count += __builtin_popcountll(a[i] & b[i]);
+  return count;
+}
+
+#endif // l1menu_popcount_dispatch
+
+// Returns the popcount_and kernels supported by the running CPU, fastest
+// first. The generic kernel is always last.
+inline std::vector<popcount_and_type>
+popcount_and_kernels()
+{
+  std::vector<popcount_and_type> kernels;
+#ifdef l1menu_popcount_dispatch
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2") and __builtin_cpu_supports("popcnt"))
+    kernels.emplace_back(popcount_and_avx2);
+  if (__builtin_cpu_supports("popcnt"))
+    kernels.emplace_back(popcount_and_popcnt);
+#endif
+  kernels.emplace_back(popcount_and_generic);
+  return kernels;
+}
+
+// Returns the fastest supported kernel, selected once on first use.
+inline popcount_and_type
+popcount_and_kernel()
+{
+  static const popcount_and_type kernel = popcount_and_kernels().front();
+  return kernel;
+}
+
+inline std::uint64_t
+popcount_and(const std::uint64_t* a, const std::uint64_t* b, const std::size_t n)
+{
+  return popcount_and_kernel()(a, b, n);
+}
+
+} // l1menu
+
+#undef l1menu_popcount_dispatch
+
+#endif // l1menu_popcount_hpp
@@ -0,0 +1,258 @@
+#ifndef l1menu_query_hpp
+#define l1menu_query_hpp
+
+#include <l1menu/l1menu.hpp>
+#include <l1menu/l1menu_popcount.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace l1menu {
+
+// Set of algorithms stored as bitset over Algorithm::index(). Indices may be
+// sparse, so there is no complement operator; use AlgorithmQuery::complement()
+// which excludes unassigned indices.
+class AlgorithmSet
+{
+public:
+    using word_type = std::uint64_t;
+    using words_type = std::vector<word_type>;
+    using span_type = std::pair<size_type, size_type>;
+    using spans_type = std::vector<span_type>;
+    using indices_type = std::vector<size_type>;
+
+    static constexpr size_type word_bits = 64;
+
+    AlgorithmSet() = default;
+    explicit AlgorithmSet(const size_type size)
+    : m_size(size), m_words((size + word_bits - 1) / word_bits, 0) {}
+    ~AlgorithmSet() = default;
+
+    size_type size() const { return m_size; }
+    const words_type& words() const { return m_words; }
+
+    bool test(const size_type index) const
+    {
+        return index < m_size and (m_words[index / word_bits] >> (index % word_bits)) & 1;
+    }
+
+    void set(const size_type index)
+    {
+        m_words[index / word_bits] |= word_type(1) << (index % word_bits);
+    }
+
+    void reset(const size_type index)
+    {
+        m_words[index / word_bits] &= ~(word_type(1) << (index % word_bits));
+    }
+
+    // Sets all bits, leaving the unused tail of the last word cleared.
+    void fill()
+    {
+        for (auto& word: m_words) word = ~word_type(0);
+        clear_tail();
+    }
+
+    size_type count() const
+    {
+        size_type n = 0;
+        for (const auto word: m_words) n += popcount64(word);
+        return n;
+    }
+
+    bool empty() const
+    {
+        for (const auto word: m_words) if (word) return false;
+        return true;
+    }
+
+    AlgorithmSet& operator&=(const AlgorithmSet& other)
+    {
+        const auto n = common_words(other);
+        for (size_type i = 0; i < n; ++i) m_words[i] &= other.m_words[i];
+        for (size_type i = n; i < m_words.size(); ++i) m_words[i] = 0;
+        return *this;
+    }
+
+    AlgorithmSet& operator|=(const AlgorithmSet& other)
+    {
+        const auto n = common_words(other);
+        for (size_type i = 0; i < n; ++i) m_words[i] |= other.m_words[i];
+        return *this;
+    }
+
+    // Removes all algorithms contained in other (AND NOT).
+    AlgorithmSet& operator-=(const AlgorithmSet& other)
+    {
+        const auto n = common_words(other);
+        for (size_type i = 0; i < n; ++i) m_words[i] &= ~other.m_words[i];
+        return *this;
+    }
+
+    // Returns set bits as sorted list of indices.
+    indices_type indices() const
+    {
+        indices_type result;
+        result.reserve(count());
+        for (size_type i = 0; i < m_words.size(); ++i)
+        {
+            auto word = m_words[i];
+            while (word)
+            {
+                result.emplace_back(i * word_bits + __builtin_ctzll(word));
+                word &= word - 1;
+            }
+        }
+        return result;
+    }
+
+    // Returns set bits as half open ranges [first, last) of consecutive indices.
+    spans_type spans() const
+    {
+        spans_type result;
+        size_type index = 0;
+        while (index < m_size)
+        {
+            const auto first = find_next(index, false);
+            if (first >= m_size) break;
+            const auto last = find_next(first, true);
+            result.emplace_back(first, last);
+            index = last;
+        }
+        return result;
+    }
+
+private:
+    size_type common_words(const AlgorithmSet& other) const
+    {
+        return std::min(m_words.size(), other.m_words.size());
+    }
+
+    void clear_tail()
+    {
+        if (m_size % word_bits and not m_words.empty())
+            m_words.back() &= (word_type(1) << (m_size % word_bits)) - 1;
+    }
+
+    // Returns position of next set (or cleared if inverted) bit starting at index.
+    size_type find_next(const size_type index, const bool inverted) const
+    {
+        auto i = index / word_bits;
+        auto word = inverted ? ~m_words[i] : m_words[i];
+        word &= ~word_type(0) << (index % word_bits);
+        while (not word)
+        {
+            if (++i >= m_words.size()) return m_size;
+            word = inverted ? ~m_words[i] : m_words[i];
+        }
+        return std::min<size_type>(m_size, i * word_bits + __builtin_ctzll(word));
+    }
+
+    size_type m_size = 0;
+    words_type m_words;
+};
+
+inline AlgorithmSet operator&(AlgorithmSet lhs, const AlgorithmSet& rhs) { return lhs &= rhs; }
+inline AlgorithmSet operator|(AlgorithmSet lhs, const AlgorithmSet& rhs) { return lhs |= rhs; }
+inline AlgorithmSet operator-(AlgorithmSet lhs, const AlgorithmSet& rhs) { return lhs -= rhs; }
+
+// Precomputed bitsets for each distinct label, module and object type of a
+// menu. The menu must outlive the query object.
+class AlgorithmQuery
+{
+public:
+    using set_type = l1menu::AlgorithmSet;
+
+    explicit AlgorithmQuery(const Menu& menu)
+    {
+        size_type size = 0;
+        for (const auto& algorithm: menu.algorithms())
+            size = std::max(size, algorithm.index() + 1);
+
+        m_all = set_type(size);
+        m_empty = set_type(size);
+        m_algorithms.assign(size, nullptr);
+
+        for (const auto& algorithm: menu.algorithms())
+        {
+            const auto index = algorithm.index();
+            m_algorithms[index] = &algorithm;
+            m_all.set(index);
+            for (const auto& label: algorithm.labels())
+                insert(m_labels, label, index);
+            insert(m_modules, algorithm.module_id(), index);
+            for (const auto& object_requirement: algorithm.object_requirements())
+                insert(m_object_types, object_requirement.type(), index);
+        }
+    }
+    ~AlgorithmQuery() = default;
+
+    size_type size() const { return m_all.size(); }
+
+    const set_type& all() const { return m_all; }
+    const set_type& none() const { return m_empty; }
+
+    const set_type& label(const text_type& label) const { return lookup(m_labels, label); }
+    const set_type& module(const size_type module_id) const { return lookup(m_modules, module_id); }
+    const set_type& object_type(const text_type& type) const { return lookup(m_object_types, type); }
+
+    // Returns algorithms not in set, restricted to algorithms of the menu.
+    set_type complement(const set_type& set) const { return m_all - set; }
+
+    // Returns algorithm for index or nullptr if the index is not assigned.
+    const Algorithm* algorithm(const size_type index) const
+    {
+        return index < m_algorithms.size() ? m_algorithms[index] : nullptr;
+    }
+
+    std::vector<const Algorithm*> algorithms(const set_type& set) const
+    {
+        std::vector<const Algorithm*> result;
+        for (const auto index: set.indices())
+            if (m_algorithms[index]) result.emplace_back(m_algorithms[index]);
+        return result;
+    }
+
+    std::vector<text_type> labels() const { return keys(m_labels); }
+    std::vector<size_type> modules() const { return keys(m_modules); }
+    std::vector<text_type> object_types() const { return keys(m_object_types); }
+
+private:
+    template<typename Map, typename Key>
+    void insert(Map& map, const Key& key, const size_type index)
+    {
+        auto it = map.find(key);
+        if (it == map.end())
+            it = map.emplace(key, m_empty).first;
+        it->second.set(index);
+    }
+
+    template<typename Map, typename Key>
+    const set_type& lookup(const Map& map, const Key& key) const
+    {
+        const auto it = map.find(key);
+        return it == map.end() ? m_empty : it->second;
+    }
+
+    template<typename Map>
+    std::vector<typename Map::key_type> keys(const Map& map) const
+    {
+        std::vector<typename Map::key_type> result;
+        for (const auto& item: map) result.emplace_back(item.first);
+        return result;
+    }
+
+    set_type m_all;
+    set_type m_empty;
+    std::vector<const Algorithm*> m_algorithms;
+    std::map<text_type, set_type> m_labels;
+    std::map<size_type, set_type> m_modules;
+    std::map<text_type, set_type> m_object_types;
+};
+
+} // l1menu
+
+#endif // l1menu_query_hpp
@@ -0,0 +1,185 @@
+#ifndef l1menu_scan_hpp
+#define l1menu_scan_hpp
+
+#include <l1menu/l1menu.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace l1menu {
+
+// Returns scale for object and type or nullptr if not found.
+inline const Scale*
+find_scale(const ScaleSet& scale_set, const text_type& object, const text_type& type)
+{
+  for (const auto& scale: scale_set.scales())
+    if (scale.object() == object and scale.type() == type)
+      return &scale;
+  return nullptr;
+}
+
+// Returns the first bin with a lower edge not below value, as done by the
+// firmware when converting thresholds. Falls back to minimum/step if the
+// scale provides no bins. Returns one past the last bin if value is out of
+// range.
+inline size_type
+threshold_to_bin(const Scale& scale, const decimal_type value)
+{
+  const decimal_type epsilon = 1e-9;
+  if (scale.bins().empty())
+  {
+    if (scale.step() <= 0) return 0;
+    const auto bin = std::ceil((value - scale.minimum()) / scale.step() - epsilon);
+    return bin < 0 ? 0 : static_cast<size_type>(bin);
+  }
+  size_type result = 0;
+  size_type n_bins = 0;
+  bool found = false;
+  for (const auto& bin: scale.bins())
+  {
+    n_bins = std::max(n_bins, bin.number() + 1);
+    if (bin.minimum() >= value - epsilon and (not found or bin.number() < result))
+    {
+      result = bin.number();
+      found = true;
+    }
+  }
+  return found ? result : n_bins;
+}
+
+// Computes pass counts of an algorithm for a list of thresholds of one of
+// its object requirements in a single pass over the events.
+//
+// Events are reduced by the caller to the leading candidate value (hardware
+// bin) of the varied requirement, or a negative value if the event fails
+// the remaining conditions of the algorithm. Values are histogrammed per
+// thread and the histograms turned into cumulative counts, so the cost is
+// independent of the number of thresholds. The menu must outlive the scan.
+class ThresholdScan
+{
+public:
+    using count_type = std::uint64_t;
+    using counts_type = std::vector<count_type>;
+    using thresholds_type = std::vector<decimal_type>;
+    using bins_type = std::vector<size_type>;
+
+    ThresholdScan(const Menu& menu, const Algorithm& algorithm,
+                  const text_type& requirement_name,
+                  const thresholds_type& thresholds)
+    : m_thresholds(thresholds)
+    {
+        const auto& requirements = algorithm.object_requirements();
+        auto it = std::find_if(requirements.begin(), requirements.end(),
+            [&](const ObjectRequirement& requirement) { return requirement.name() == requirement_name; });
+        if (it == requirements.end())
+            throw std::runtime_error("no object requirement '" + requirement_name + "' in algorithm '" + algorithm.name() + "'");
+        m_requirement = *it;
+
+        if (m_requirement.comparison_operator() == ".ge.") m_cumulative = true;
+        else if (m_requirement.comparison_operator() == ".eq.") m_cumulative = false;
+        else throw std::runtime_error("unsupported comparison operator '" + m_requirement.comparison_operator() + "'");
+
+        for (const auto& type: {"ET", "PT"})
+        {
+            m_scale = find_scale(menu.scale_set(), m_requirement.type(), type);
+            if (m_scale) break;
+        }
+        if (not m_scale)
+            throw std::runtime_error("no threshold scale for object type '" + m_requirement.type() + "'");
+
+        size_type n_bins = 0;
+        for (const auto& bin: m_scale->bins())
+            n_bins = std::max(n_bins, bin.number() + 1);
+        if (not n_bins and m_scale->nbits() < 32)
+            n_bins = size_type(1) << m_scale->nbits();
+        m_n_bins = std::max<size_type>(n_bins, 1);
+
+        for (const auto threshold: m_thresholds)
+            m_threshold_bins.emplace_back(threshold_to_bin(*m_scale, threshold));
+    }
+    ~ThresholdScan() = default;
+
+    const ObjectRequirement& requirement() const { return m_requirement; }
+    const Scale& scale() const { return *m_scale; }
+    const thresholds_type& thresholds() const { return m_thresholds; }
+    const bins_type& threshold_bins() const { return m_threshold_bins; }
+
+    // Number of histogram entries, one per scale bin plus one for values
+    // beyond the scale.
+    size_type histogram_size() const { return m_n_bins + 1; }
+
+    // Returns pass counts in order of thresholds. Value is called with each
+    // event and returns its leading candidate bin (negative if failing).
+    // Values beyond the scale saturate in the last bin for .ge. and never
+    // match for .eq. requirements. Iterator must be random access.
+    template<typename Iterator, typename Value>
+    counts_type run(Iterator first, Iterator last, Value value,
+                    size_type n_threads = std::thread::hardware_concurrency()) const
+    {
+        const auto n_events = static_cast<std::size_t>(std::distance(first, last));
+        n_threads = std::max<size_type>(1, std::min<std::size_t>(n_threads, n_events / min_events_per_thread + 1));
+
+        std::vector<counts_type> histograms(n_threads, counts_type(histogram_size(), 0));
+        const auto fill = [&](const size_type thread) {
+            auto& histogram = histograms[thread];
+            auto begin = first + n_events * thread / n_threads;
+            auto end = first + n_events * (thread + 1) / n_threads;
+            for (auto it = begin; it != end; ++it)
+            {
+                const auto bin = value(*it);
+                if (bin < 0) continue;
+                ++histogram[std::min<std::size_t>(bin, m_n_bins)];
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (size_type thread = 1; thread < n_threads; ++thread)
+            threads.emplace_back(fill, thread);
+        fill(0);
+        for (auto& thread: threads)
+            thread.join();
+
+        auto& histogram = histograms.front();
+        for (size_type thread = 1; thread < n_threads; ++thread)
+            for (size_type bin = 0; bin < histogram_size(); ++bin)
+                histogram[bin] += histograms[thread][bin];
+
+        return counts(histogram);
+    }
+
+    // Returns pass counts in order of thresholds from an already filled
+    // histogram of leading candidate bins of histogram_size() entries, the
+    // last entry counting values beyond the scale. The overflow entry only
+    // contributes to cumulative (.ge.) counts.
+    counts_type counts(counts_type histogram) const
+    {
+        if (m_cumulative)
+            for (size_type bin = histogram.size(); bin-- > 1;)
+                histogram[bin - 1] += histogram[bin];
+
+        counts_type result;
+        result.reserve(m_threshold_bins.size());
+        for (const auto bin: m_threshold_bins)
+            result.emplace_back(bin < m_n_bins and bin < histogram.size() ? histogram[bin] : 0);
+        return result;
+    }
+
+private:
+    static constexpr std::size_t min_events_per_thread = 65536;
+
+    ObjectRequirement m_requirement;
+    const Scale* m_scale = nullptr;
+    thresholds_type m_thresholds;
+    bins_type m_threshold_bins;
+    size_type m_n_bins = 0;
+    bool m_cumulative = true;
+};
+
+} // l1menu
+
+#endif // l1menu_scan_hpp
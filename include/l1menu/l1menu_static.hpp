@@ -0,0 +1,379 @@
+#ifndef l1menu_static_hpp
+#define l1menu_static_hpp
+
+#include <l1menu/l1menu.hpp>
+
+namespace l1menu {
+
+// Literal types holding a menu in constexpr tables, as emitted by write_cpp()
+// (see l1menu_codegen.hpp). Accessors mirror those of the l1menu classes but
+// return plain C strings and StaticRange views instead of std containers.
+
+template<typename T>
+class StaticRange
+{
+public:
+    using value_type = T;
+    using const_iterator = const T*;
+
+    constexpr StaticRange() : m_data(nullptr), m_size(0) {}
+    constexpr StaticRange(const T* data, const size_type size)
+    : m_data(data), m_size(size) {}
+
+    constexpr const T* begin() const { return m_data; }
+    constexpr const T* end() const { return m_data + m_size; }
+    constexpr size_type size() const { return m_size; }
+    constexpr bool empty() const { return m_size == 0; }
+    constexpr const T& operator[](const size_type i) const { return m_data[i]; }
+
+private:
+    const T* m_data;
+    size_type m_size;
+};
+
+using static_text_type = const char*;
+
+class StaticCut
+{
+public:
+    constexpr StaticCut(static_text_type name, static_text_type object, static_text_type type,
+                        const decimal_type minimum, const decimal_type maximum,
+                        static_text_type data, static_text_type comment)
+    : m_name(name), m_object(object), m_type(type), m_minimum(minimum),
+      m_maximum(maximum), m_data(data), m_comment(comment) {}
+
+    constexpr static_text_type name() const { return m_name; }
+    constexpr static_text_type object() const { return m_object; }
+    constexpr static_text_type type() const { return m_type; }
+    constexpr decimal_type minimum() const { return m_minimum; }
+    constexpr decimal_type maximum() const { return m_maximum; }
+    constexpr static_text_type data() const { return m_data; }
+    constexpr static_text_type comment() const { return m_comment; }
+
+private:
+    static_text_type m_name;
+    static_text_type m_object;
+    static_text_type m_type;
+    decimal_type m_minimum;
+    decimal_type m_maximum;
+    static_text_type m_data;
+    static_text_type m_comment;
+};
+
+class StaticObjectRequirement
+{
+public:
+    constexpr StaticObjectRequirement(static_text_type name, static_text_type type,
+                                      static_text_type comparison_operator,
+                                      const decimal_type threshold, const offset_type bx_offset,
+                                      static_text_type comment)
+    : m_name(name), m_type(type), m_comparison_operator(comparison_operator),
+      m_threshold(threshold), m_bx_offset(bx_offset), m_comment(comment) {}
+
+    constexpr static_text_type name() const { return m_name; }
+    constexpr static_text_type type() const { return m_type; }
+    constexpr static_text_type comparison_operator() const { return m_comparison_operator; }
+    constexpr decimal_type threshold() const { return m_threshold; }
+    constexpr offset_type bx_offset() const { return m_bx_offset; }
+    constexpr static_text_type comment() const { return m_comment; }
+
+private:
+    static_text_type m_name;
+    static_text_type m_type;
+    static_text_type m_comparison_operator;
+    decimal_type m_threshold;
+    offset_type m_bx_offset;
+    static_text_type m_comment;
+};
+
+class StaticExternalRequirement
+{
+public:
+    constexpr StaticExternalRequirement(static_text_type name, const offset_type bx_offset,
+                                        static_text_type comment)
+    : m_name(name), m_bx_offset(bx_offset), m_comment(comment) {}
+
+    constexpr static_text_type name() const { return m_name; }
+    constexpr offset_type bx_offset() const { return m_bx_offset; }
+    constexpr static_text_type comment() const { return m_comment; }
+
+private:
+    static_text_type m_name;
+    offset_type m_bx_offset;
+    static_text_type m_comment;
+};
+
+class StaticAlgorithm
+{
+public:
+    using labels_type = StaticRange<static_text_type>;
+    using cuts_type = StaticRange<StaticCut>;
+    using object_requirements_type = StaticRange<StaticObjectRequirement>;
+    using external_requirements_type = StaticRange<StaticExternalRequirement>;
+
+    constexpr StaticAlgorithm(static_text_type name, static_text_type expression,
+                              const size_type index, const size_type module_id,
+                              const size_type module_index, static_text_type comment,
+                              const labels_type labels, const cuts_type cuts,
+                              const object_requirements_type object_requirements,
+                              const external_requirements_type external_requirements)
+    : m_name(name), m_expression(expression), m_index(index),
+      m_module_id(module_id), m_module_index(module_index), m_comment(comment),
+      m_labels(labels), m_cuts(cuts), m_object_requirements(object_requirements),
+      m_external_requirements(external_requirements) {}
+
+    constexpr static_text_type name() const { return m_name; }
+    constexpr static_text_type expression() const { return m_expression; }
+    constexpr size_type index() const { return m_index; }
+    constexpr size_type module_id() const { return m_module_id; }
+    constexpr size_type module_index() const { return m_module_index; }
+    constexpr static_text_type comment() const { return m_comment; }
+    constexpr labels_type labels() const { return m_labels; }
+    constexpr cuts_type cuts() const { return m_cuts; }
+    constexpr object_requirements_type object_requirements() const { return m_object_requirements; }
+    constexpr external_requirements_type external_requirements() const { return m_external_requirements; }
+
+private:
+    static_text_type m_name;
+    static_text_type m_expression;
+    size_type m_index;
+    size_type m_module_id;
+    size_type m_module_index;
+    static_text_type m_comment;
+    labels_type m_labels;
+    cuts_type m_cuts;
+    object_requirements_type m_object_requirements;
+    external_requirements_type m_external_requirements;
+};
+
+class StaticBin
+{
+public:
+    constexpr StaticBin(const size_type number, const decimal_type minimum,
+                        const decimal_type maximum)
+    : m_number(number), m_minimum(minimum), m_maximum(maximum) {}
+
+    constexpr size_type number() const { return m_number; }
+    constexpr decimal_type minimum() const { return m_minimum; }
+    constexpr decimal_type maximum() const { return m_maximum; }
+
+private:
+    size_type m_number;
+    decimal_type m_minimum;
+    decimal_type m_maximum;
+};
+
+class StaticScale
+{
+public:
+    using bins_type = StaticRange<StaticBin>;
+
+    constexpr StaticScale(static_text_type object, static_text_type type,
+                          const decimal_type minimum, const decimal_type maximum,
+                          const decimal_type step, const size_type nbits,
+                          static_text_type comment, const bins_type bins)
+    : m_object(object), m_type(type), m_minimum(minimum), m_maximum(maximum),
+      m_step(step), m_nbits(nbits), m_comment(comment), m_bins(bins) {}
+
+    constexpr static_text_type object() const { return m_object; }
+    constexpr static_text_type type() const { return m_type; }
+    constexpr decimal_type minimum() const { return m_minimum; }
+    constexpr decimal_type maximum() const { return m_maximum; }
+    constexpr decimal_type step() const { return m_step; }
+    constexpr size_type nbits() const { return m_nbits; }
+    constexpr static_text_type comment() const { return m_comment; }
+    constexpr bins_type bins() const { return m_bins; }
+
+private:
+    static_text_type m_object;
+    static_text_type m_type;
+    decimal_type m_minimum;
+    decimal_type m_maximum;
+    decimal_type m_step;
+    size_type m_nbits;
+    static_text_type m_comment;
+    bins_type m_bins;
+};
+
+class StaticScaleSet
+{
+public:
+    using scales_type = StaticRange<StaticScale>;
+
+    constexpr StaticScaleSet(static_text_type name, static_text_type comment,
+                             const scales_type scales)
+    : m_name(name), m_comment(comment), m_scales(scales) {}
+
+    constexpr static_text_type name() const { return m_name; }
+    constexpr static_text_type comment() const { return m_comment; }
+    constexpr scales_type scales() const { return m_scales; }
+
+private:
+    static_text_type m_name;
+    static_text_type m_comment;
+    scales_type m_scales;
+};
+
+class StaticExtSignal
+{
+public:
+    constexpr StaticExtSignal(static_text_type name, static_text_type system,
+                              const size_type cable, const size_type channel,
+                              static_text_type description, static_text_type label)
+    : m_name(name), m_system(system), m_cable(cable), m_channel(channel),
+      m_description(description), m_label(label) {}
+
+    constexpr static_text_type name() const { return m_name; }
+    constexpr static_text_type system() const { return m_system; }
+    constexpr size_type cable() const { return m_cable; }
+    constexpr size_type channel() const { return m_channel; }
+    constexpr static_text_type description() const { return m_description; }
+    constexpr static_text_type label() const { return m_label; }
+
+private:
+    static_text_type m_name;
+    static_text_type m_system;
+    size_type m_cable;
+    size_type m_channel;
+    static_text_type m_description;
+    static_text_type m_label;
+};
+
+class StaticExtSignalSet
+{
+public:
+    using ext_signals_type = StaticRange<StaticExtSignal>;
+
+    constexpr StaticExtSignalSet(static_text_type name, static_text_type comment,
+                                 const ext_signals_type ext_signals)
+    : m_name(name), m_comment(comment), m_ext_signals(ext_signals) {}
+
+    constexpr static_text_type name() const { return m_name; }
+    constexpr static_text_type comment() const { return m_comment; }
+    constexpr ext_signals_type ext_signals() const { return m_ext_signals; }
+
+private:
+    static_text_type m_name;
+    static_text_type m_comment;
+    ext_signals_type m_ext_signals;
+};
+
+class StaticMenu
+{
+public:
+    using algorithms_type = StaticRange<StaticAlgorithm>;
+    using scale_set_type = StaticScaleSet;
+    using ext_signal_set_type = StaticExtSignalSet;
+
+    constexpr StaticMenu(static_text_type name, static_text_type uuid_menu,
+                         static_text_type uuid_firmware, static_text_type grammar_version,
+                         const size_type n_modules, static_text_type comment,
+                         const algorithms_type algorithms, const scale_set_type scale_set,
+                         const ext_signal_set_type ext_signal_set)
+    : m_name(name), m_uuid_menu(uuid_menu), m_uuid_firmware(uuid_firmware),
+      m_grammar_version(grammar_version), m_n_modules(n_modules),
+      m_comment(comment), m_algorithms(algorithms), m_scale_set(scale_set),
+      m_ext_signal_set(ext_signal_set) {}
+
+    constexpr static_text_type name() const { return m_name; }
+    constexpr static_text_type uuid_menu() const { return m_uuid_menu; }
+    constexpr static_text_type uuid_firmware() const { return m_uuid_firmware; }
+    constexpr static_text_type grammar_version() const { return m_grammar_version; }
+    constexpr size_type n_modules() const { return m_n_modules; }
+    constexpr static_text_type comment() const { return m_comment; }
+    constexpr algorithms_type algorithms() const { return m_algorithms; }
+    constexpr const scale_set_type& scale_set() const { return m_scale_set; }
+    constexpr const ext_signal_set_type& ext_signal_set() const { return m_ext_signal_set; }
+
+private:
+    static_text_type m_name;
+    static_text_type m_uuid_menu;
+    static_text_type m_uuid_firmware;
+    static_text_type m_grammar_version;
+    size_type m_n_modules;
+    static_text_type m_comment;
+    algorithms_type m_algorithms;
+    scale_set_type m_scale_set;
+    ext_signal_set_type m_ext_signal_set;
+};
+
+// Converts an embedded menu into a regular l1menu::Menu.
+inline l1menu::Menu
+to_menu(const StaticMenu& static_menu)
+{
+  l1menu::Menu menu(
+    static_menu.name(), static_menu.uuid_menu(), static_menu.uuid_firmware(),
+    static_menu.grammar_version(), static_menu.n_modules(), static_menu.comment()
+  );
+
+  for (const auto& static_algorithm: static_menu.algorithms())
+  {
+    l1menu::Algorithm::labels_type labels(
+      static_algorithm.labels().begin(), static_algorithm.labels().end()
+    );
+
+    l1menu::Algorithm algorithm(
+      static_algorithm.name(), static_algorithm.expression(),
+      static_algorithm.index(), static_algorithm.module_id(),
+      static_algorithm.module_index(), static_algorithm.comment(), labels
+    );
+
+    l1menu::Algorithm::cuts_type cuts;
+    for (const auto& cut: static_algorithm.cuts())
+      cuts.emplace_back(
+        cut.name(), cut.object(), cut.type(), cut.minimum(), cut.maximum(),
+        cut.data(), cut.comment()
+      );
+    algorithm.set_cuts(cuts);
+
+    l1menu::Algorithm::object_requirements_type object_requirements;
+    for (const auto& object_requirement: static_algorithm.object_requirements())
+      object_requirements.emplace_back(
+        object_requirement.name(), object_requirement.type(),
+        object_requirement.comparison_operator(), object_requirement.threshold(),
+        object_requirement.bx_offset(), object_requirement.comment()
+      );
+    algorithm.set_object_requirements(object_requirements);
+
+    l1menu::Algorithm::external_requirements_type external_requirements;
+    for (const auto& external_requirement: static_algorithm.external_requirements())
+      external_requirements.emplace_back(
+        external_requirement.name(), external_requirement.bx_offset(),
+        external_requirement.comment()
+      );
+    algorithm.set_external_requirements(external_requirements);
+
+    menu.add_algorithm(algorithm);
+  }
+
+  l1menu::ScaleSet scale_set;
+  scale_set.set_name(static_menu.scale_set().name());
+  scale_set.set_comment(static_menu.scale_set().comment());
+  for (const auto& scale: static_menu.scale_set().scales())
+  {
+    l1menu::Scale::bins_type bins;
+    for (const auto& bin: scale.bins())
+      bins.emplace_back(bin.number(), bin.minimum(), bin.maximum());
+    scale_set.add_scale(l1menu::Scale(
+      scale.object(), scale.type(), scale.minimum(), scale.maximum(),
+      scale.step(), scale.nbits(), bins
+    ));
+  }
+  menu.set_scale_set(scale_set);
+
+  l1menu::ExtSignalSet ext_signal_set;
+  ext_signal_set.set_name(static_menu.ext_signal_set().name());
+  ext_signal_set.set_comment(static_menu.ext_signal_set().comment());
+  for (const auto& ext_signal: static_menu.ext_signal_set().ext_signals())
+    ext_signal_set.add_ext_signal(l1menu::ExtSignal(
+      ext_signal.name(), ext_signal.system(), ext_signal.cable(),
+      ext_signal.channel(), ext_signal.description(), ext_signal.label()
+    ));
+  menu.set_ext_signal_set(ext_signal_set);
+
+  return menu;
+}
+
+} // l1menu
+
+#endif // l1menu_static_hpp
@@ -9,7 +9,12 @@
 #include <boost/format.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/tokenizer.hpp>
+#include <boost/iostreams/filtering_stream.hpp>
+#include <boost/iostreams/filter/gzip.hpp>
+#include <boost/iostreams/filter/zstd.hpp>
 
+#include <algorithm>
+#include <fstream>
 #include <sstream>
 
 namespace l1menu {
@@ -21,7 +26,7 @@ format_decimal(const T& v)
   return boost::str(boost::format("%+23.16E") % (v));
 }
 
-std::vector<std::string>
+inline std::vector<std::string>
 tokenize(const std::string& text)
 {
   std::vector<std::string> s;
@@ -48,18 +53,179 @@ T get_value(const N& node, const std::string& key)
   }
 }
 
-l1menu::Menu
-read_xml(const std::string& filename)
+enum class compression_type { none, gzip, zstd };
+
+const std::streamsize COMPRESSION_MAGIC_SIZE = 4;
+
+// Detects compression from the leading magic bytes of a stream.
+inline compression_type
+detect_compression(const std::string& magic)
+{
+  const auto byte = [&](const std::size_t i) { return static_cast<unsigned char>(magic[i]); };
+  if (magic.size() >= 2 and byte(0) == 0x1f and byte(1) == 0x8b)
+    return compression_type::gzip;
+  if (magic.size() >= 4 and byte(0) == 0x28 and byte(1) == 0xb5 and byte(2) == 0x2f and byte(3) == 0xfd)
+    return compression_type::zstd;
+  return compression_type::none;
+}
+
+// Source returning an already consumed prefix followed by the remainder of
+// a stream, puts back magic bytes read from non-seekable streams (pipes).
+class PrefixedSource
+{
+public:
+  using char_type = char;
+  using category = boost::iostreams::source_tag;
+
+  PrefixedSource(const std::string& prefix, std::istream& is)
+  : m_prefix(prefix), m_is(&is) {}
+
+  std::streamsize read(char* s, std::streamsize n)
+  {
+    std::streamsize count = 0;
+    if (m_position < m_prefix.size())
+    {
+      count = std::min<std::streamsize>(n, m_prefix.size() - m_position);
+      m_prefix.copy(s, count, m_position);
+      m_position += count;
+    }
+    if (count < n and *m_is)
+    {
+      m_is->read(s + count, n - count);
+      count += m_is->gcount();
+    }
+    return count ? count : -1;
+  }
+
+private:
+  std::string m_prefix;
+  std::size_t m_position = 0;
+  std::istream* m_is;
+};
+
+// Guesses output compression from a file name extension (.gz, .zst).
+inline compression_type
+compression_from_filename(const std::string& filename)
+{
+  if (boost::algorithm::iends_with(filename, ".gz"))
+    return compression_type::gzip;
+  if (boost::algorithm::iends_with(filename, ".zst"))
+    return compression_type::zstd;
+  return compression_type::none;
+}
+
+template<typename Chain>
+void push_decompressor(Chain& chain, const compression_type compression)
+{
+  switch (compression)
+  {
+    case compression_type::gzip:
+      chain.push(boost::iostreams::gzip_decompressor());
+      break;
+    case compression_type::zstd:
+      chain.push(boost::iostreams::zstd_decompressor());
+      break;
+    case compression_type::none:
+      break;
+  }
+}
+
+template<typename Chain>
+void push_compressor(Chain& chain, const compression_type compression)
+{
+  switch (compression)
+  {
+    case compression_type::gzip:
+      chain.push(boost::iostreams::gzip_compressor());
+      break;
+    case compression_type::zstd:
+      chain.push(boost::iostreams::zstd_compressor());
+      break;
+    case compression_type::none:
+      break;
+  }
+}
+
+inline l1menu::Menu
+read_xml(const pugi::xml_document& doc);
+
+// Reads a menu from a plain, gzip or zstd compressed stream, which may be
+// non-seekable (pipes, std::cin). Compressed input is decompressed through a
+// filter chain into pugixml. Note that pugixml reads non-seekable input in
+// chunks and copies them into one contiguous buffer, so peak memory holds
+// the decompressed document about twice; only plain seekable input is read
+// into a single buffer.
+inline l1menu::Menu
+read_xml(std::istream& is)
 {
   pugi::xml_document doc;
+  pugi::xml_parse_result result;
 
-  pugi::xml_parse_result result = doc.load_file(filename.c_str(), pugi::parse_default, pugi::encoding_utf8);
+  const auto position = is.tellg();
+  std::string magic(COMPRESSION_MAGIC_SIZE, '\0');
+  is.read(&magic[0], magic.size());
+  magic.resize(is.gcount());
+  if (is.bad())
+  {
+    throw std::runtime_error("failed to read input stream");
+  }
+  is.clear();
+
+  const auto compression = detect_compression(magic);
+
+  if (compression == compression_type::none and position != std::streampos(-1) and is.seekg(position))
+  {
+    result = doc.load(is, pugi::parse_default, pugi::encoding_utf8);
+  }
+  else
+  {
+    is.clear();
+    boost::iostreams::filtering_istream fis;
+    push_decompressor(fis, compression);
+    fis.push(PrefixedSource(magic, is));
+    // pugixml probes with tellg(), which filtering streams answer by throwing.
+    // The stream turns this into badbit which pugixml clears, so exceptions
+    // must stay disabled and filter errors are detected by badbit afterwards.
+    result = doc.load(fis, pugi::parse_default, pugi::encoding_utf8);
+    if (fis.bad())
+    {
+      switch (compression)
+      {
+        case compression_type::gzip:
+          throw std::runtime_error("gzip decompression failed");
+        case compression_type::zstd:
+          throw std::runtime_error("zstd decompression failed");
+        case compression_type::none:
+          break;
+      }
+      throw std::runtime_error("failed to read input stream");
+    }
+  }
 
   if (not result)
   {
     throw std::runtime_error(result.description());
   }
 
+  return read_xml(doc);
+}
+
+inline l1menu::Menu
+read_xml(const std::string& filename)
+{
+  std::ifstream ifs(filename, std::ios::in | std::ios::binary);
+
+  if (not ifs)
+  {
+    throw std::runtime_error("failed to open file '" + filename + "'");
+  }
+
+  return read_xml(ifs);
+}
+
+inline l1menu::Menu
+read_xml(const pugi::xml_document& doc)
+{
   const auto& menu_node = doc.child("tmxsd:menu");
 
   auto name = get_value<text_type>(menu_node, "name");
@@ -219,8 +385,11 @@ void xml_append_node_optional(Node& node, const Key& key, const Value& value)
   if (text.size()) node.append_child(key).append_child(pugi::node_pcdata).set_value(text.c_str());
 }
 
-std::string
-write_xml(const l1menu::Menu& menu)
+// Writes a menu to a stream, optionally compressing output as it is
+// produced.
+inline void
+write_xml(const l1menu::Menu& menu, std::ostream& os,
+          const compression_type compression = compression_type::none)
 {
   pugi::xml_document doc;
 
@@ -321,12 +490,49 @@ write_xml(const l1menu::Menu& menu)
     xml_append_node_optional(ext_signal_node, "label", ext_signal.label());
   }
 
-  std::ostringstream oss;
-  doc.save(oss, "  ", pugi::format_default, pugi::encoding_utf8);
+  if (compression == compression_type::none)
+  {
+    doc.save(os, "  ", pugi::format_default, pugi::encoding_utf8);
+  }
+  else
+  {
+    boost::iostreams::filtering_ostream fos;
+    push_compressor(fos, compression);
+    fos.push(os);
+    doc.save(fos, "  ", pugi::format_default, pugi::encoding_utf8);
+    fos.reset();
+  }
+}
 
+inline std::string
+write_xml(const l1menu::Menu& menu)
+{
+  std::ostringstream oss;
+  write_xml(menu, oss);
   return oss.str();
 }
 
+// Writes a menu to file, compression defaults to the file name extension.
+inline void
+write_xml_file(const l1menu::Menu& menu, const std::string& filename,
+               const compression_type compression)
+{
+  std::ofstream ofs(filename, std::ios::out | std::ios::binary);
+
+  if (not ofs)
+  {
+    throw std::runtime_error("failed to open file '" + filename + "'");
+  }
+
+  write_xml(menu, ofs, compression);
+}
+
+inline void
+write_xml_file(const l1menu::Menu& menu, const std::string& filename)
+{
+  write_xml_file(menu, filename, compression_from_filename(filename));
+}
+
 } // l1menu
 
 #endif // l1menu_xml_hpp
@@ -2,15 +2,37 @@
 %{
 #include "../include/l1menu/l1menu.hpp"
 #include "../include/l1menu/l1menu_xml.hpp"
+#include "../include/l1menu/l1menu_codegen.hpp"
+#include "../include/l1menu/l1menu_json.hpp"
 %}
 
 %include <std_string.i>
 %include <std_vector.i>
 %include <std_set.i>
 
+// Stream and raw buffer interfaces can not be used safely from Python, a
+// char* argument is a temporary copy of the Python string. Expose only the
+// file name and std::string entry points.
+%ignore l1menu::read_xml(std::istream&);
+%ignore l1menu::read_xml(const pugi::xml_document&);
+%ignore l1menu::write_xml(const l1menu::Menu&, std::ostream&, const l1menu::compression_type);
+%ignore l1menu::write_xml(const l1menu::Menu&, std::ostream&);
+%ignore l1menu::detect_compression;
+%ignore l1menu::PrefixedSource;
+%ignore l1menu::write_cpp(const l1menu::Menu&, std::ostream&, const std::string&);
+%ignore l1menu::write_json(const l1menu::Menu&, std::ostream&, const l1menu::JsonOptions&);
+%ignore l1menu::write_json(const l1menu::Menu&, std::ostream&);
+%ignore l1menu::write_json(const l1menu::Menu&, char*, const std::size_t, const l1menu::JsonOptions&);
+%ignore l1menu::write_json(const l1menu::Menu&, char*, const std::size_t);
+%ignore l1menu::JsonStreamSink;
+%ignore l1menu::JsonBufferSink;
+%ignore l1menu::JsonWriter;
+
 // Parse the original header file
 %include "../include/l1menu/l1menu.hpp"
 %include "../include/l1menu/l1menu_xml.hpp"
+%include "../include/l1menu/l1menu_codegen.hpp"
+%include "../include/l1menu/l1menu_json.hpp"
 
 // Instantiate some templates
 %template(cut_vector) std::vector<l1menu::Cut>;
@@ -0,0 +1,369 @@
+#include <l1menu/l1menu.hpp>
+#include <l1menu/l1menu_xml.hpp>
+#include <l1menu/l1menu_query.hpp>
+#include <l1menu/l1menu_scan.hpp>
+#include <l1menu/l1menu_json.hpp>
+#include <l1menu/l1menu_overlap.hpp>
+#include <l1menu/l1menu_external.hpp>
+
+#include <sys/resource.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+using clock_type = std::chrono::steady_clock;
+using l1menu::size_type;
+
+long peak_rss_kb()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+double elapsed_ms(const clock_type::time_point& start)
+{
+  return std::chrono::duration<double, std::milli>(clock_type::now() - start).count();
+}
+
+std::streamoff file_size(const std::string& filename)
+{
+  std::ifstream ifs(filename, std::ios::in | std::ios::binary | std::ios::ate);
+  return ifs.tellg();
+}
+
+void report(const std::string& what, const double ms, const std::streamoff bytes)
+{
+  std::cout << what << ": " << ms << " ms, " << bytes << " bytes";
+  if (ms > 0) std::cout << ", " << (bytes / 1048576.) / (ms / 1000.) << " MiB/s";
+  std::cout << ", peak rss " << peak_rss_kb() << " kB" << std::endl;
+}
+
+// Builds a menu of 300 algorithms, each with two cuts and two object
+// requirements, 10 scales of 512 bins and 100 external signals spread over
+// 8 cables, for benchmarks run without an input file. Every third algorithm
+// requires two external signals.
+l1menu::Menu synthetic_menu()
+{
+  l1menu::Menu menu("L1Menu_synthetic");
+  for (size_type i = 0; i < 300; ++i)
+  {
+    l1menu::Algorithm algorithm(
+      "L1_Synthetic_" + std::to_string(i), "comb{MU3,MU5}[MU-ETA_2p1,MU-QLTY_SNGL]",
+      i, i % 6, i / 6, "", {"synthetic", "mu"}
+    );
+    algorithm.set_cuts({
+      l1menu::Cut("MU-ETA_2p1", "Mu", "ETA", -2.1, 2.1, "", ""),
+      l1menu::Cut("MU-QLTY_SNGL", "Mu", "QLTY", 0, 0, "12,13,14,15", "")
+    });
+    algorithm.set_object_requirements({
+      l1menu::ObjectRequirement("MU3", "Mu", ".ge.", 3, 0, ""),
+      l1menu::ObjectRequirement("MU5", "Mu", ".ge.", 5, 0, "")
+    });
+    if (i % 3 == 0)
+      algorithm.set_external_requirements({
+        l1menu::ExternalRequirement("EXT_SYNTHETIC_" + std::to_string(i % 100), 0, ""),
+        l1menu::ExternalRequirement("EXT_SYNTHETIC_" + std::to_string((i * 7 + 1) % 100), -1, "")
+      });
+    menu.add_algorithm(algorithm);
+  }
+  l1menu::ScaleSet scale_set;
+  for (size_type i = 0; i < 10; ++i)
+  {
+    l1menu::Scale::bins_type bins;
+    for (size_type bin = 0; bin < 512; ++bin)
+      bins.emplace_back(bin, bin * .5, (bin + 1) * .5);
+    scale_set.add_scale(l1menu::Scale("Mu", "PT" + std::to_string(i), 0, 256, .5, 9, bins));
+  }
+  menu.set_scale_set(scale_set);
+  l1menu::ExtSignalSet ext_signal_set;
+  for (size_type i = 0; i < 100; ++i)
+    ext_signal_set.add_ext_signal(l1menu::ExtSignal(
+      "SYNTHETIC_" + std::to_string(i), "SYNTHETIC", i * 7 % 8, i * 13 % 32, "", ""
+    ));
+  menu.set_ext_signal_set(ext_signal_set);
+  return menu;
+}
+
+// Reads the menu given as first benchmark argument, or builds the synthetic
+// menu if there is none.
+l1menu::Menu load_menu(int argc, char* argv[])
+{
+  return argc < 3 ? synthetic_menu() : l1menu::read_xml(argv[2]);
+}
+
+// Run each read/write in its own process to get meaningful peak RSS figures,
+// compression of written files follows the extension (.xml, .xml.gz, .xml.zst).
+int bench_read(int argc, char* argv[])
+{
+  if (argc < 3) return 1;
+  const std::string filename = argv[2];
+  auto start = clock_type::now();
+  auto menu = l1menu::read_xml(filename);
+  report("read " + filename, elapsed_ms(start), file_size(filename));
+  return menu.algorithms().empty();
+}
+
+int bench_write(int argc, char* argv[])
+{
+  if (argc < 4) return 1;
+  const std::string filename = argv[3];
+  auto menu = l1menu::read_xml(argv[2]);
+  auto start = clock_type::now();
+  l1menu::write_xml_file(menu, filename);
+  report("write " + filename, elapsed_ms(start), file_size(filename));
+  return 0;
+}
+
+// Evaluates (label AND NOT exclude_label) for every module of the menu.
+int bench_query(int argc, char* argv[])
+{
+  if (argc < 5) return 1;
+  const size_type iterations = 100000;
+  auto menu = l1menu::read_xml(argv[2]);
+  auto start = clock_type::now();
+  l1menu::AlgorithmQuery query(menu);
+  std::cout << "build query: " << elapsed_ms(start) << " ms" << std::endl;
+  const auto modules = query.modules();
+  size_type matches = 0;
+  start = clock_type::now();
+  for (size_type i = 0; i < iterations; ++i)
+  {
+    const auto module_id = modules.empty() ? 0 : modules[i % modules.size()];
+    const auto result = (query.label(argv[3]) - query.label(argv[4])) & query.module(module_id);
+    matches += result.spans().size();
+  }
+  const auto ms = elapsed_ms(start);
+  std::cout << "query: " << (ms * 1000. / iterations) << " us/query, " << matches << " spans" << std::endl;
+  return 0;
+}
+
+// Scans thresholds 0..max of the first requirement of an algorithm over
+// random leading candidate bins and compares against one pass per threshold.
+int bench_scan(int argc, char* argv[])
+{
+  if (argc < 4) return 1;
+  const size_type n_events = 10000000;
+  const size_type n_thresholds = 50;
+  auto menu = l1menu::read_xml(argv[2]);
+  const auto& algorithms = menu.algorithms();
+  auto it = std::find_if(algorithms.begin(), algorithms.end(),
+    [&](const l1menu::Algorithm& algorithm) { return algorithm.name() == argv[3]; });
+  if (it == algorithms.end() or it->object_requirements().empty()) return 1;
+
+  l1menu::ThresholdScan::thresholds_type thresholds;
+  for (size_type i = 0; i < n_thresholds; ++i) thresholds.emplace_back(i * 2);
+  l1menu::ThresholdScan scan(menu, *it, it->object_requirements().front().name(), thresholds);
+
+  std::vector<l1menu::offset_type> events(n_events);
+  std::mt19937 generator(42);
+  std::geometric_distribution<l1menu::offset_type> distribution(0.02);
+  for (auto& event: events) event = distribution(generator) - 1;
+  const auto value = [](const l1menu::offset_type bin) { return bin; };
+
+  auto start = clock_type::now();
+  const auto counts = scan.run(events.begin(), events.end(), value);
+  const auto ms_scan = elapsed_ms(start);
+
+  start = clock_type::now();
+  l1menu::ThresholdScan::count_type mismatches = 0;
+  for (size_type i = 0; i < n_thresholds; ++i)
+  {
+    l1menu::ThresholdScan::count_type count = 0;
+    const l1menu::offset_type threshold_bin = scan.threshold_bins()[i];
+    for (const auto event: events)
+      count += event >= threshold_bin;
+    mismatches += count != counts[i];
+  }
+  const auto ms_naive = elapsed_ms(start);
+
+  std::cout << "scan: " << ms_scan << " ms, per threshold loop: " << ms_naive << " ms, "
+            << n_thresholds << " thresholds, " << n_events << " events" << std::endl;
+  return mismatches != 0;
+}
+
+template<typename Function>
+void bench_serializer(const std::string& what, const size_type iterations, Function function)
+{
+  std::size_t bytes = 0;
+  auto start = clock_type::now();
+  for (size_type i = 0; i < iterations; ++i)
+    bytes += function();
+  report(what, elapsed_ms(start), bytes);
+}
+
+int bench_json(int argc, char* argv[])
+{
+  if (argc < 3) return 1;
+  const size_type iterations = 20;
+  auto menu = l1menu::read_xml(argv[2]);
+
+  bench_serializer("write_xml", iterations, [&]() -> std::size_t {
+    return l1menu::write_xml(menu).size();
+  });
+  bench_serializer("write_json ostream", iterations, [&]() -> std::size_t {
+    std::ostringstream oss;
+    l1menu::write_json(menu, oss);
+    return oss.str().size();
+  });
+  l1menu::JsonOptions options;
+  options.bins = false;
+  bench_serializer("write_json ostream without bins", iterations, [&]() -> std::size_t {
+    std::ostringstream oss;
+    l1menu::write_json(menu, oss, options);
+    return oss.str().size();
+  });
+  std::vector<char> buffer(l1menu::write_json(menu, nullptr, 0));
+  bench_serializer("write_json buffer", iterations, [&]() -> std::size_t {
+    return l1menu::write_json(menu, buffer.data(), buffer.size());
+  });
+  return 0;
+}
+
+// Creates variants of a menu each raising the first threshold of a few
+// algorithms, reports creation time and resident memory growth.
+int bench_variants(int argc, char* argv[])
+{
+  const size_type n_variants = 10000;
+  const size_type n_modified = 3;
+  auto menu = load_menu(argc, argv);
+  if (menu.algorithms().empty()) return 1;
+  const auto rss = peak_rss_kb();
+
+  std::vector<l1menu::Menu> variants;
+  variants.reserve(n_variants);
+  auto start = clock_type::now();
+  for (size_type i = 0; i < n_variants; ++i)
+  {
+    variants.emplace_back(menu);
+    auto& algorithms = variants.back().algorithms();
+    for (size_type j = 0; j < n_modified; ++j)
+    {
+      auto& algorithm = algorithms[(i * n_modified + j) % algorithms.size()];
+      auto object_requirements = algorithm.object_requirements();
+      if (object_requirements.empty()) continue;
+      object_requirements.front().set_threshold(object_requirements.front().threshold() + i % 10);
+      algorithm.set_object_requirements(object_requirements);
+    }
+  }
+  const auto ms = elapsed_ms(start);
+
+  std::cout << n_variants << " variants: " << ms << " ms, "
+            << (peak_rss_kb() - rss) << " kB rss growth" << std::endl;
+  return 0;
+}
+
+// Fills the overlap matrix from random decisions firing each algorithm with
+// a probability of 1/1000, using all hardware threads unless given.
+int bench_overlap(int argc, char* argv[])
+{
+  const size_type n_events = 10000000;
+  const size_type n_threads = argc < 4 ? std::thread::hardware_concurrency() : std::stoul(argv[3]);
+  auto menu = load_menu(argc, argv);
+  l1menu::OverlapMatrix matrix(menu);
+  const auto n_words = matrix.words_per_event();
+
+  std::vector<l1menu::OverlapMatrix::word_type> decisions(std::size_t(n_events) * n_words, 0);
+  std::mt19937 generator(42);
+  std::uniform_int_distribution<size_type> distribution(0, 1000 * matrix.size());
+  for (size_type event = 0; event < n_events; ++event)
+    for (size_type i = 0; i < 4; ++i)
+    {
+      const auto index = distribution(generator);
+      if (index < matrix.size())
+        decisions[std::size_t(event) * n_words + index / 64] |= std::uint64_t(1) << (index % 64);
+    }
+
+  auto start = clock_type::now();
+  matrix.fill(decisions.data(), n_events, n_threads);
+  const auto ms = elapsed_ms(start);
+  std::cout << "overlap: " << ms << " ms, " << n_threads << " threads, " << n_events << " events, "
+            << matrix.size() << " algorithms, " << matrix.total() << " triggered" << std::endl;
+  for (const auto& algorithm: menu.algorithms())
+    std::cout << "  " << matrix.name(algorithm.index()) << ": rate " << matrix.rate(algorithm.index())
+              << ", unique " << matrix.unique(algorithm.index()) << std::endl;
+  return 0;
+}
+
+// Decodes full orbits of random raw external condition words, 8 cables per
+// BX unless given, and evaluates the external requirements of all algorithms
+// for every BX.
+int bench_external(int argc, char* argv[])
+{
+  const size_type n_bx = 3564;
+  const size_type n_orbits = 1000;
+  const size_type n_cables = argc < 4 ? 8 : std::stoul(argv[3]);
+  auto menu = load_menu(argc, argv);
+  l1menu::ExtSignalDecoder decoder(menu.ext_signal_set(), n_cables);
+
+  std::vector<l1menu::ExtSignalDecoder::conditions_type> conditions;
+  for (const auto& algorithm: menu.algorithms())
+    if (not algorithm.external_requirements().empty())
+      conditions.emplace_back(decoder.resolve(algorithm));
+
+  std::vector<l1menu::ExtSignalDecoder::raw_word_type> raw(std::size_t(n_bx) * decoder.raw_words_per_bx());
+  std::mt19937 generator(42);
+  for (auto& word: raw) word = generator() & generator();
+  std::vector<l1menu::ExtSignalDecoder::word_type> decoded(std::size_t(n_bx) * decoder.words_per_bx());
+
+  auto start = clock_type::now();
+  for (size_type orbit = 0; orbit < n_orbits; ++orbit)
+    decoder.decode(raw.data(), n_bx, decoded.data());
+  const auto ms_decode = elapsed_ms(start);
+
+  std::size_t passed = 0;
+  start = clock_type::now();
+  for (size_type orbit = 0; orbit < n_orbits; ++orbit)
+    for (size_type bx = 0; bx < n_bx; ++bx)
+      for (const auto& algorithm_conditions: conditions)
+        passed += decoder.test(decoded.data(), n_bx, bx, algorithm_conditions);
+  const auto ms_test = elapsed_ms(start);
+
+  const auto n = double(n_bx) * n_orbits;
+  std::cout << "decode: " << (ms_decode * 1e6 / n) << " ns/bx, " << decoder.n_signals() << " signals, "
+            << (ms_decode / n_orbits) << " ms/orbit" << std::endl;
+  std::cout << "test: " << (ms_test * 1e6 / n) << " ns/bx, " << conditions.size() << " algorithms, "
+            << passed << " passed" << std::endl;
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  const std::map<std::string, std::function<int(int, char*[])>> benchmarks {
+    {"read", bench_read},
+    {"write", bench_write},
+    {"query", bench_query},
+    {"scan", bench_scan},
+    {"json", bench_json},
+    {"variants", bench_variants},
+    {"overlap", bench_overlap},
+    {"external", bench_external},
+  };
+
+  if (argc < 2 or not benchmarks.count(argv[1]))
+  {
+    std::cerr << "usage: " << argv[0] << " <benchmark> [args...]\n";
+    std::cerr << "  read <menu.xml[.gz|.zst]>\n";
+    std::cerr << "  write <menu.xml> <output.xml[.gz|.zst]>\n";
+    std::cerr << "  query <menu.xml> <label> <exclude_label>\n";
+    std::cerr << "  scan <menu.xml> <algorithm>\n";
+    std::cerr << "  json <menu.xml>\n";
+    std::cerr << "  variants [menu.xml]\n";
+    std::cerr << "  overlap [menu.xml [threads]]\n";
+    std::cerr << "  external [menu.xml [cables]]\n";
+    return 1;
+  }
+
+  return benchmarks.at(argv[1])(argc, argv);
+}
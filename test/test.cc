@@ -1,15 +1,265 @@
 #include <l1menu/l1menu.hpp>
 #include <l1menu/l1menu_xml.hpp>
 #include <l1menu/l1menu_print.hpp>
+#include <l1menu/l1menu_overlap.hpp>
+#include <l1menu/l1menu_external.hpp>
+#include <l1menu/l1menu_popcount.hpp>
 
+#include <functional>
 #include <iostream>
+#include <random>
+#include <sstream>
+#include <streambuf>
+
+// Stream buffer over a string which, like a pipe, does not support seeking.
+class NonSeekableBuffer : public std::streambuf
+{
+public:
+  explicit NonSeekableBuffer(const std::string& data) : m_data(data)
+  {
+    setg(&m_data[0], &m_data[0], &m_data[0] + m_data.size());
+  }
+
+private:
+  std::string m_data;
+};
+
+// Writes the menu with each compression, reads it back from a seekable and a
+// non-seekable stream and compares the serialized result with the original.
+bool test_compression_roundtrip(const l1menu::Menu& menu)
+{
+  const auto expected = l1menu::write_xml(menu);
+  bool success = true;
+  for (const auto compression: {l1menu::compression_type::none,
+                                l1menu::compression_type::gzip,
+                                l1menu::compression_type::zstd})
+  {
+    std::stringstream ss;
+    l1menu::write_xml(menu, ss, compression);
+    if (compression != l1menu::compression_type::none and
+        ss.str().compare(0, 4, expected, 0, 4) == 0)
+    {
+      std::cerr << "roundtrip: output not compressed (" << static_cast<int>(compression) << ")" << std::endl;
+      success = false;
+    }
+    NonSeekableBuffer buffer(ss.str());
+    std::istream pipe(&buffer);
+    if (l1menu::write_xml(l1menu::read_xml(ss)) != expected or
+        l1menu::write_xml(l1menu::read_xml(pipe)) != expected)
+    {
+      std::cerr << "roundtrip: mismatch (" << static_cast<int>(compression) << ")" << std::endl;
+      success = false;
+    }
+  }
+  return success;
+}
+
+// Builds a small menu in memory for tests not requiring an input file.
+l1menu::Menu synthetic_menu()
+{
+  l1menu::Menu menu("L1Menu_test");
+  for (l1menu::size_type i = 0; i < 4; ++i)
+  {
+    l1menu::Algorithm algorithm("L1_Test_" + std::to_string(i), "MU3", i, 0, i, "", {"test"});
+    algorithm.set_object_requirements({l1menu::ObjectRequirement("MU3", "Mu", ".ge.", 3, 0, "")});
+    menu.add_algorithm(algorithm);
+  }
+  return menu;
+}
+
+// Copies share algorithm data until modified, modifications never show in
+// other copies.
+bool test_copy_on_write()
+{
+  bool success = true;
+  const auto check = [&success](const bool condition, const char* what) {
+    if (not condition)
+    {
+      std::cerr << "copy on write: " << what << std::endl;
+      success = false;
+    }
+  };
+
+  const auto menu = synthetic_menu();
+  auto copy = menu;
+  for (l1menu::size_type i = 0; i < menu.algorithms().size(); ++i)
+    check(copy.algorithms()[i].shares_data(menu.algorithms()[i]), "copy does not share data");
+
+  copy.algorithms()[1].set_name("L1_Modified");
+  copy.algorithms()[1].add_label("modified");
+  check(not copy.algorithms()[1].shares_data(menu.algorithms()[1]), "modified algorithm still shared");
+  check(copy.algorithms()[1].name() == "L1_Modified", "modification lost");
+  check(copy.algorithms()[1].labels().size() == 2, "label not added");
+  check(menu.algorithms()[1].name() == "L1_Test_1", "original name changed");
+  check(menu.algorithms()[1].labels().size() == 1, "original labels changed");
+  for (const l1menu::size_type i: {0, 2, 3})
+    check(copy.algorithms()[i].shares_data(menu.algorithms()[i]), "untouched algorithm detached");
+
+  auto variant = copy;
+  variant.algorithms()[1].set_index(42);
+  check(copy.algorithms()[1].index() == 1, "copy of modified algorithm changed");
+
+  l1menu::Algorithm algorithm;
+  const l1menu::Algorithm other;
+  check(algorithm.shares_data(other), "default algorithms do not share data");
+  algorithm.set_name("L1_Default");
+  algorithm.add_label("default");
+  check(not algorithm.shares_data(other), "modified default algorithm still shared");
+  check(other.name().empty() and other.labels().empty(), "shared default modified");
+  check(l1menu::Algorithm().name().empty() and l1menu::Algorithm().labels().empty(), "new default modified");
+
+  return success;
+}
+
+// Compares all popcount kernels supported by the CPU and the overlap matrix,
+// filled by several threads in several calls, with brute force counts.
+bool test_overlap()
+{
+  bool success = true;
+  std::mt19937_64 generator(42);
+
+  std::vector<std::uint64_t> a(133), b(133);
+  for (auto& word: a) word = generator();
+  for (auto& word: b) word = generator() | generator();
+  a[7] = b[7] = ~std::uint64_t(0);
+  const auto kernels = l1menu::popcount_and_kernels();
+  for (std::size_t offset = 0; offset < 4; ++offset)
+    for (std::size_t n = 0; n + offset <= a.size(); ++n)
+    {
+      std::uint64_t expected = 0;
+      for (std::size_t i = offset; i < offset + n; ++i)
+        for (std::size_t bit = 0; bit < 64; ++bit)
+          expected += (a[i] & b[i]) >> bit & 1;
+      for (std::size_t kernel = 0; kernel < kernels.size(); ++kernel)
+        if (kernels[kernel](&a[offset], &b[offset], n) != expected)
+        {
+          std::cerr << "overlap: popcount kernel " << kernel << " wrong for " << n << " words" << std::endl;
+          success = false;
+        }
+    }
+
+  // Sparse indices with gaps, every fifth index firing often.
+  l1menu::Menu menu("L1Menu_overlap");
+  for (l1menu::size_type i = 0; i < 100; ++i)
+    if (i != 7)
+      menu.add_algorithm(l1menu::Algorithm("L1_Overlap_" + std::to_string(i), "", i * 3 / 2, 0, i, "", {}));
+  l1menu::OverlapMatrix matrix(menu);
+  const auto size = matrix.size();
+  const auto n_words = matrix.words_per_event();
+  const std::size_t n_events = 3 * l1menu::OverlapMatrix::block_events + 123;
+  std::vector<std::uint64_t> decisions(n_events * n_words, 0);
+  for (std::size_t event = 0; event < n_events; ++event)
+    for (const auto& algorithm: menu.algorithms())
+    {
+      const auto index = algorithm.index();
+      if (generator() % (index % 5 == 0 ? 3 : 97) == 0)
+        decisions[event * n_words + index / 64] |= std::uint64_t(1) << (index % 64);
+    }
+
+  std::vector<std::uint64_t> overlaps(std::size_t(size) * size), unique(size);
+  std::uint64_t total = 0;
+  for (std::size_t event = 0; event < n_events; ++event)
+  {
+    std::vector<l1menu::size_type> fired;
+    for (l1menu::size_type index = 0; index < size; ++index)
+      if (decisions[event * n_words + index / 64] >> (index % 64) & 1)
+        fired.emplace_back(index);
+    if (not fired.empty()) ++total;
+    if (fired.size() == 1) ++unique[fired.front()];
+    for (const auto i: fired)
+      for (const auto j: fired)
+        ++overlaps[std::size_t(i) * size + j];
+  }
+
+  // Repeated calls, first with several threads then with one.
+  const std::size_t split = n_events / 2;
+  matrix.fill(decisions.data(), split, 3);
+  matrix.fill(decisions.data() + split * n_words, n_events - split, 2);
+  matrix.fill(decisions.data(), n_events, 1);
+  bool matches = matrix.events() == 2 * n_events and matrix.total() == 2 * total;
+  for (l1menu::size_type i = 0; i < size; ++i)
+  {
+    matches = matches and matrix.unique(i) == 2 * unique[i];
+    for (l1menu::size_type j = 0; j < size; ++j)
+      matches = matches and matrix.overlap(i, j) == 2 * overlaps[std::size_t(i) * size + j];
+  }
+  if (not matches)
+  {
+    std::cerr << "overlap: matrix differs from brute force count" << std::endl;
+    success = false;
+  }
+
+  return success;
+}
+
+// Decodes raw words of a signal set not using the last cable, which must not
+// change the raw stride, and checks input validation.
+bool test_external()
+{
+  bool success = true;
+  const l1menu::size_type n_cables = 4;
+  const l1menu::size_type n_bx = 5;
+
+  l1menu::ExtSignalSet ext_signal_set;
+  ext_signal_set.add_ext_signal(l1menu::ExtSignal("A", "", 0, 3, "", ""));
+  ext_signal_set.add_ext_signal(l1menu::ExtSignal("B", "", 1, 31, "", ""));
+  ext_signal_set.add_ext_signal(l1menu::ExtSignal("C", "", 1, 31, "", ""));
+  const l1menu::ExtSignalDecoder decoder(ext_signal_set, n_cables);
+
+  std::vector<l1menu::ExtSignalDecoder::raw_word_type> raw(n_bx * n_cables, 0);
+  raw[2 * n_cables + 0] = 1u << 3;
+  raw[3 * n_cables + 1] = 1u << 31;
+  raw[4 * n_cables + 3] = ~0u;
+  const auto decoded = decoder.decode(raw);
+  const std::vector<l1menu::ExtSignalDecoder::word_type> expected {0, 0, 1, 6, 0};
+  if (decoded != expected)
+  {
+    std::cerr << "external: wrong decoded words" << std::endl;
+    success = false;
+  }
+
+  l1menu::Algorithm algorithm;
+  algorithm.set_external_requirements({l1menu::ExternalRequirement("EXT_A", -1, ""),
+                                       l1menu::ExternalRequirement("C", 0, "")});
+  const auto conditions = decoder.resolve(algorithm);
+  for (l1menu::size_type bx = 0; bx < n_bx; ++bx)
+    if (decoder.test(decoded.data(), n_bx, bx, conditions) != (bx == 3))
+    {
+      std::cerr << "external: wrong condition result for bx " << bx << std::endl;
+      success = false;
+    }
+
+  const auto throws = [](const std::function<void()>& f) {
+    try { f(); } catch (const std::runtime_error&) { return true; }
+    return false;
+  };
+  raw.pop_back();
+  if (not throws([&] { decoder.decode(raw); }) or
+      not throws([&] { l1menu::ExtSignalDecoder(ext_signal_set, 1); }))
+  {
+    std::cerr << "external: invalid input accepted" << std::endl;
+    success = false;
+  }
+
+  return success;
+}
 
 int main(int argc, char* argv[])
 {
-  const std::string filename = argv[1];
+  bool success = test_copy_on_write();
+  success = test_overlap() and success;
+  success = test_external() and success;
+
+  if (argc > 1)
+  {
+    const std::string filename = argv[1];
+
+    auto menu = l1menu::read_xml(filename);
 
-  auto menu = l1menu::read_xml(filename);
+    std::cout << l1menu::write_xml(menu);
 
-  std::cout << l1menu::write_xml(menu);
+    success = test_compression_roundtrip(menu) and success;
+  }
 
+  return success ? 0 : 1;
 }